@@ -119,6 +119,8 @@ endif
 SRC += $(KEYBOARD_C) \
 	$(KEYMAP_C) \
 	$(QUANTUM_DIR)/quantum.c \
+	$(QUANTUM_DIR)/deferred.c \
+	$(QUANTUM_DIR)/settings.c \
 	$(QUANTUM_DIR)/keymap_common.c \
 	$(QUANTUM_DIR)/keycode_config.c \
 	$(QUANTUM_DIR)/process_keycode/process_leader.c
@@ -127,10 +129,28 @@ ifneq ($(SUBPROJECT),)
 	SRC += $(SUBPROJECT_C)
 endif
 
+ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
+	OPT_DEFS += -DSPLIT_KEYBOARD
+	SRC += $(QUANTUM_DIR)/split_common/split_util.c \
+	       $(QUANTUM_DIR)/split_common/transport.c \
+	       $(QUANTUM_DIR)/split_common/i2c.c \
+	       $(QUANTUM_DIR)/split_common/serial.c \
+	       $(QUANTUM_DIR)/split_common/serial_usart.c
+	VPATH += $(QUANTUM_PATH)/split_common
+ifndef CUSTOM_MATRIX
+	SRC += $(QUANTUM_DIR)/split_common/matrix.c
+	CUSTOM_MATRIX = yes
+endif
+endif
+
 ifndef CUSTOM_MATRIX
 	SRC += $(QUANTUM_DIR)/matrix.c
 endif
 
+ifeq ($(strip $(SPARSE_KEYMAP_ENABLE)), yes)
+	OPT_DEFS += -DSPARSE_KEYMAP_ENABLE
+endif
+
 ifeq ($(strip $(API_SYSEX_ENABLE)), yes)
 	OPT_DEFS += -DAPI_SYSEX_ENABLE
 	SRC += $(QUANTUM_DIR)/api/api_sysex.c
@@ -190,6 +210,16 @@ ifeq ($(strip $(RGBLIGHT_ENABLE)), yes)
 	SRC += $(QUANTUM_DIR)/rgblight.c
 endif
 
+ifeq ($(strip $(ASYNC_MACRO_ENABLE)), yes)
+	OPT_DEFS += -DASYNC_MACRO_ENABLE
+	SRC += $(QUANTUM_DIR)/async_macro.c
+endif
+
+ifeq ($(strip $(DYNAMIC_KEYMAP_ENABLE)), yes)
+	OPT_DEFS += -DDYNAMIC_KEYMAP_ENABLE
+	SRC += $(QUANTUM_DIR)/dynamic_keymap.c
+endif
+
 ifeq ($(strip $(TAP_DANCE_ENABLE)), yes)
 	OPT_DEFS += -DTAP_DANCE_ENABLE
 	SRC += $(QUANTUM_DIR)/process_keycode/process_tap_dance.c
@@ -201,6 +231,11 @@ ifeq ($(strip $(PRINTING_ENABLE)), yes)
 	SRC += $(TMK_DIR)/protocol/serial_uart.c
 endif
 
+ifeq ($(strip $(TWI_ASYNC_ENABLE)), yes)
+	OPT_DEFS += -DTWI_ASYNC_ENABLE
+	SRC += $(QUANTUM_DIR)/twi_async.c
+endif
+
 ifeq ($(strip $(SERIAL_LINK_ENABLE)), yes)
 	SRC += $(patsubst $(QUANTUM_PATH)/%,%,$(SERIAL_SRC))
 	OPT_DEFS += $(SERIAL_DEFS)
@@ -18,23 +18,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdint.h>
 #include <stdbool.h>
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <util/delay.h>
 #include "print.h"
 #include "util.h"
 #include "debug.h"
 #include "ps2.h"
 #include "matrix.h"
+#include "progmem.h"
+#include "scan_decoder.h"
 
 #define print_matrix_row(row)  print_bin_reverse8(matrix_get_row(row))
 #define print_matrix_header()  print("\nr/c 01234567\n")
-#define matrix_bitpop(i)       bitpop(matrix[i])
 #define ROW_SHIFTER ((uint8_t)1)
 
 
-static void matrix_make(uint8_t code);
-static void matrix_break(uint8_t code);
-
-
 /*
  * Matrix Array usage:
  * 'Scan Code Set 3' is assigned into 17x8 cell matrix.
@@ -47,9 +45,32 @@ static void matrix_break(uint8_t code);
  * 17|         |
  *   +---------+
  */
-static uint8_t matrix[MATRIX_ROWS];
-#define ROW(code)      (code>>3)
-#define COL(code)      (code&0x07)
+#define SCAN_CODE_COUNT 0x88
+
+static const scan_prefix_t prefixes[] PROGMEM = {
+    { 0, 0xF0, SCAN_BREAK },
+};
+
+static const scan_decoder_t decoder = {
+    .prefixes = prefixes,
+    .prefix_count = sizeof(prefixes) / sizeof(prefixes[0]),
+    .key_count = SCAN_CODE_COUNT,
+};
+
+static bool is_scan_code(uint8_t code)
+{
+    return (code && code < SCAN_CODE_COUNT) || code == 0xF0;
+}
+
+// scan code reading states
+static volatile enum {
+    RESET,
+    RESET_RESPONSE,
+    KBD_ID0,
+    KBD_ID1,
+    CONFIG,
+    READY,
+} state = RESET;
 
 
 __attribute__ ((weak))
@@ -63,29 +84,25 @@ void matrix_init(void)
     //debug_keyboard = true;
     //debug_mouse = false;
 
+    scan_decoder_init(&decoder);
     ps2_host_init();
 
-    // initialize matrix state: all keys off
-    for (uint8_t i=0; i < MATRIX_ROWS; i++) matrix[i] = 0x00;
-
     matrix_init_user();
     return;
 }
 
-uint8_t matrix_scan(void)
+/* Once configured the scan codes go to the decoder straight from the
+ * interrupt, replies to commands like 0xFA are left to ps2_host_send(). */
+bool ps2_host_recv_hook(uint8_t data, uint8_t error)
 {
+    if (state != READY || error || !is_scan_code(data))
+        return false;
+    scan_decoder_put(data);
+    return true;
+}
 
-    // scan code reading states
-    static enum {
-        RESET,
-        RESET_RESPONSE,
-        KBD_ID0,
-        KBD_ID1,
-        CONFIG,
-        READY,
-        F0,
-    } state = RESET;
-
+uint8_t matrix_scan(void)
+{
     uint8_t code;
     if ((code = ps2_host_recv())) {
         debug("r"); debug_hex(code); debug(" ");
@@ -128,35 +145,15 @@ uint8_t matrix_scan(void)
             }
             break;
         case READY:
-            switch (code) {
-                case 0x00:
-                    break;
-                case 0xF0:
-                    state = F0;
-                    debug(" ");
-                    break;
-                default:    // normal key make
-                    if (code < 0x88) {
-                        matrix_make(code);
-                    } else {
-                        debug("unexpected scan code at READY: "); debug_hex(code); debug("\n");
-                    }
-                    state = READY;
-                    debug("\n");
-            }
-            break;
-        case F0:    // Break code
-            switch (code) {
-                case 0x00:
-                    break;
-                default:
-                    if (code < 0x88) {
-                        matrix_break(code);
-                    } else {
-                        debug("unexpected scan code at F0: "); debug_hex(code); debug("\n");
-                    }
-                    state = READY;
-                    debug("\n");
+            // the PS/2 host without receive hook leaves scan codes here
+            if (is_scan_code(code)) {
+                // the receive hook puts from the interrupt as well
+                uint8_t sreg = SREG;
+                cli();
+                scan_decoder_put(code);
+                SREG = sreg;
+            } else if (code) {
+                debug("unexpected scan code at READY: "); debug_hex(code); debug("\n");
             }
             break;
     }
@@ -166,23 +163,7 @@ uint8_t matrix_scan(void)
 inline
 uint8_t matrix_get_row(uint8_t row)
 {
-    return matrix[row];
-}
-
-inline
-static void matrix_make(uint8_t code)
-{
-    if (!matrix_is_on(ROW(code), COL(code))) {
-        matrix[ROW(code)] |= 1<<COL(code);
-    }
-}
-
-inline
-static void matrix_break(uint8_t code)
-{
-    if (matrix_is_on(ROW(code), COL(code))) {
-        matrix[ROW(code)] &= ~(1<<COL(code));
-    }
+    return scan_decoder_get_row(row);
 }
 
 bool matrix_is_on(uint8_t row, uint8_t col)
@@ -65,6 +65,7 @@ RGBLIGHT_ENABLE ?= no        # Enable WS2812 RGB underlight.  Do not enable this
 PS2_USE_USART ?= yes
 API_SYSEX_ENABLE ?= n
 CUSTOM_MATRIX = yes
+SCAN_DECODER_ENABLE = yes
 
 # Do not enable SLEEP_LED_ENABLE. it uses the same timer as BACKLIGHT_ENABLE
 SLEEP_LED_ENABLE ?= no    # Breathing sleep LED during USB suspend
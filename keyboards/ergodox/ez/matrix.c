@@ -35,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "matrix.h"
 #include "ez.h"
 #include "i2cmaster.h"
+#include "twi_async.h"
 #ifdef DEBUG_MATRIX_SCAN_RATE
 #include  "timer.h"
 #endif
@@ -63,9 +64,57 @@ static matrix_row_t read_cols(uint8_t row);
 static void init_cols(void);
 static void unselect_rows(void);
 static void select_row(uint8_t row);
+static bool mcp23018_probe(void);
+static void mcp23018_queue_row(uint8_t row);
+static matrix_row_t mcp23018_read_row(void);
+static void mcp23018_unselect_rows(void);
 
 static uint8_t mcp23018_reset_loop;
 
+/* The left hand is read over interrupt driven I2C: selecting a row on the
+ * mcp23018 and reading its columns back is queued up front, and the matching
+ * row on the teensy is scanned while those transactions are on the bus.
+ */
+static uint8_t mcp23018_select_data[2] = { GPIOA, 0xFF };
+static twi_transaction_t mcp23018_select = {
+    .address = I2C_ADDR,
+    .tx = mcp23018_select_data,
+    .tx_length = sizeof(mcp23018_select_data),
+};
+
+static const uint8_t mcp23018_read_reg = GPIOB;
+static uint8_t mcp23018_read_data;
+static twi_transaction_t mcp23018_read = {
+    .address = I2C_ADDR,
+    .tx = &mcp23018_read_reg,
+    .tx_length = 1,
+    .rx = &mcp23018_read_data,
+    .rx_length = 1,
+};
+
+/* Selecting every row at once and reading GPIOB back tells whether any key
+ * on the left hand is down. The mcp23018 auto increments the register
+ * address after the GPIOA write, so the repeated start reads GPIOB without
+ * sending its address and the probe is a single transaction.
+ */
+static const uint8_t mcp23018_probe_data[2] = { GPIOA, 0xFF & ~0x7F & ~(0<<7) };
+static uint8_t mcp23018_probe_result;
+static twi_transaction_t mcp23018_probe_transaction = {
+    .address = I2C_ADDR,
+    .tx = mcp23018_probe_data,
+    .tx_length = sizeof(mcp23018_probe_data),
+    .rx = &mcp23018_probe_result,
+    .rx_length = 1,
+};
+
+// set all rows hi-Z : 1
+static const uint8_t mcp23018_unselect_data[2] = { GPIOA, 0xFF & ~(0<<7) };
+static twi_transaction_t mcp23018_unselect = {
+    .address = I2C_ADDR,
+    .tx = mcp23018_unselect_data,
+    .tx_length = sizeof(mcp23018_unselect_data),
+};
+
 #ifdef DEBUG_MATRIX_SCAN_RATE
 uint32_t matrix_timer;
 uint32_t matrix_scan_count;
@@ -107,6 +156,7 @@ void matrix_init(void)
     mcp23018_status = init_mcp23018();
 
 
+    mcp23018_unselect_rows();
     unselect_rows();
     init_cols();
 
@@ -126,8 +176,10 @@ void matrix_init(void)
 }
 
 void matrix_power_up(void) {
+    twi_wait_idle();
     mcp23018_status = init_mcp23018();
 
+    mcp23018_unselect_rows();
     unselect_rows();
     init_cols();
 
@@ -144,6 +196,17 @@ void matrix_power_up(void) {
 
 }
 
+static void store_row(uint8_t row, matrix_row_t cols)
+{
+    if (matrix_debouncing[row] != cols) {
+        matrix_debouncing[row] = cols;
+        if (debouncing) {
+            debug("bounce!: "); debug_hex(debouncing); debug("\n");
+        }
+        debouncing = DEBOUNCE;
+    }
+}
+
 uint8_t matrix_scan(void)
 {
     if (mcp23018_status) { // if there was an error
@@ -151,6 +214,7 @@ uint8_t matrix_scan(void)
             // since mcp23018_reset_loop is 8 bit - we'll try to reset once in 255 matrix scans
             // this will be approx bit more frequent than once per second
             print("trying to reset mcp23018\n");
+            twi_wait_idle();
             mcp23018_status = init_mcp23018();
             if (mcp23018_status) {
                 print("left side not responding\n");
@@ -175,18 +239,28 @@ uint8_t matrix_scan(void)
     }
 #endif
 
-    for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
-        select_row(i);
-        wait_us(30);  // without this wait read unstable value.
-        matrix_row_t cols = read_cols(i);
-        if (matrix_debouncing[i] != cols) {
-            matrix_debouncing[i] = cols;
-            if (debouncing) {
-                debug("bounce!: "); debug_hex(debouncing); debug("\n");
-            }
-            debouncing = DEBOUNCE;
+    // the left hand rows are only read one by one when a key is down there,
+    // otherwise they are all known to be empty
+    bool left_pressed = mcp23018_probe();
+
+    // left hand row i is read from the mcp23018 while right hand row i + 7
+    // is read from the teensy
+    for (uint8_t i = 0; i < 7; i++) {
+        if (left_pressed) {
+            mcp23018_queue_row(i);
         }
+
+        select_row(i + 7);
+        wait_us(30);  // without this wait read unstable value.
+        store_row(i + 7, read_cols(i + 7));
         unselect_rows();
+
+        store_row(i, left_pressed ? mcp23018_read_row() : 0);
+    }
+    // after an empty probe the rows stay selected until the next scan, that
+    // saves a transaction and the next probe selects them all again anyway
+    if (left_pressed) {
+        mcp23018_unselect_rows();
     }
 
     if (debouncing) {
@@ -265,29 +339,67 @@ static void  init_cols(void)
 
 static matrix_row_t read_cols(uint8_t row)
 {
-    if (row < 7) {
-        if (mcp23018_status) { // if there was an error
-            return 0;
-        } else {
-            uint8_t data = 0;
-            mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
-            mcp23018_status = i2c_write(GPIOB);             if (mcp23018_status) goto out;
-            mcp23018_status = i2c_start(I2C_ADDR_READ);     if (mcp23018_status) goto out;
-            data = i2c_readNak();
-            data = ~data;
-        out:
-            i2c_stop();
-            return data;
-        }
+    // read from teensy, the mcp23018 rows go through mcp23018_read_row()
+    return
+        (PINF&(1<<0) ? 0 : (1<<0)) |
+        (PINF&(1<<1) ? 0 : (1<<1)) |
+        (PINF&(1<<4) ? 0 : (1<<2)) |
+        (PINF&(1<<5) ? 0 : (1<<3)) |
+        (PINF&(1<<6) ? 0 : (1<<4)) |
+        (PINF&(1<<7) ? 0 : (1<<5)) ;
+}
+
+static bool mcp23018_probe(void)
+{
+    if (mcp23018_status) { // if there was an error
+        return false;
+    }
+    twi_queue(&mcp23018_probe_transaction);
+    mcp23018_status = twi_wait(&mcp23018_probe_transaction);
+    if (mcp23018_status) {
+        return false;
+    }
+    // a column reads low while any key on it is down
+    return (~mcp23018_probe_result & 0x3F) != 0;
+}
+
+static void mcp23018_queue_row(uint8_t row)
+{
+    if (mcp23018_status) { // if there was an error
+        return;
+    }
+    // set active row low  : 0
+    // set other rows hi-Z : 1
+    // there's no need to unselect the previous row, writing GPIOA does that
+    mcp23018_select_data[1] = 0xFF & ~(1<<row) & ~(0<<7);
+    twi_queue(&mcp23018_select);
+    // the register address and the repeated start take well over the 30us
+    // the row needs to settle before GPIOB is sampled
+    twi_queue(&mcp23018_read);
+}
+
+static matrix_row_t mcp23018_read_row(void)
+{
+    if (mcp23018_status) { // if there was an error
+        return 0;
+    }
+    mcp23018_status = twi_wait(&mcp23018_select);
+    if (twi_wait(&mcp23018_read) != TWI_OK) {
+        mcp23018_status = TWI_ERROR;
+    }
+    if (mcp23018_status) {
+        return 0;
+    }
+    return (uint8_t)~mcp23018_read_data;
+}
+
+static void mcp23018_unselect_rows(void)
+{
+    if (mcp23018_status) { // if there was an error
+        // do nothing
     } else {
-        // read from teensy
-        return
-            (PINF&(1<<0) ? 0 : (1<<0)) |
-            (PINF&(1<<1) ? 0 : (1<<1)) |
-            (PINF&(1<<4) ? 0 : (1<<2)) |
-            (PINF&(1<<5) ? 0 : (1<<3)) |
-            (PINF&(1<<6) ? 0 : (1<<4)) |
-            (PINF&(1<<7) ? 0 : (1<<5)) ;
+        // queued after the last read, so it never needs waiting on
+        twi_queue(&mcp23018_unselect);
     }
 }
 
@@ -303,20 +415,6 @@ static matrix_row_t read_cols(uint8_t row)
  */
 static void unselect_rows(void)
 {
-    // unselect on mcp23018
-    if (mcp23018_status) { // if there was an error
-        // do nothing
-    } else {
-        // set all rows hi-Z : 1
-        mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
-        mcp23018_status = i2c_write(GPIOA);             if (mcp23018_status) goto out;
-        mcp23018_status = i2c_write( 0xFF
-                              & ~(0<<7)
-                          );                            if (mcp23018_status) goto out;
-    out:
-        i2c_stop();
-    }
-
     // unselect on teensy
     // Hi-Z(DDR:0, PORT:0) to unselect
     DDRB  &= ~(1<<0 | 1<<1 | 1<<2 | 1<<3);
@@ -329,54 +427,37 @@ static void unselect_rows(void)
 
 static void select_row(uint8_t row)
 {
-    if (row < 7) {
-        // select on mcp23018
-        if (mcp23018_status) { // if there was an error
-            // do nothing
-        } else {
-            // set active row low  : 0
-            // set other rows hi-Z : 1
-            mcp23018_status = i2c_start(I2C_ADDR_WRITE);        if (mcp23018_status) goto out;
-            mcp23018_status = i2c_write(GPIOA);                 if (mcp23018_status) goto out;
-            mcp23018_status = i2c_write( 0xFF & ~(1<<row)
-                                  & ~(0<<7)
-                              );                                if (mcp23018_status) goto out;
-        out:
-            i2c_stop();
-        }
-    } else {
-        // select on teensy
-        // Output low(DDR:1, PORT:0) to select
-        switch (row) {
-            case 7:
-                DDRB  |= (1<<0);
-                PORTB &= ~(1<<0);
-                break;
-            case 8:
-                DDRB  |= (1<<1);
-                PORTB &= ~(1<<1);
-                break;
-            case 9:
-                DDRB  |= (1<<2);
-                PORTB &= ~(1<<2);
-                break;
-            case 10:
-                DDRB  |= (1<<3);
-                PORTB &= ~(1<<3);
-                break;
-            case 11:
-                DDRD  |= (1<<2);
-                PORTD &= ~(1<<3);
-                break;
-            case 12:
-                DDRD  |= (1<<3);
-                PORTD &= ~(1<<3);
-                break;
-            case 13:
-                DDRC  |= (1<<6);
-                PORTC &= ~(1<<6);
-                break;
-        }
+    // select on teensy
+    // Output low(DDR:1, PORT:0) to select
+    switch (row) {
+        case 7:
+            DDRB  |= (1<<0);
+            PORTB &= ~(1<<0);
+            break;
+        case 8:
+            DDRB  |= (1<<1);
+            PORTB &= ~(1<<1);
+            break;
+        case 9:
+            DDRB  |= (1<<2);
+            PORTB &= ~(1<<2);
+            break;
+        case 10:
+            DDRB  |= (1<<3);
+            PORTB &= ~(1<<3);
+            break;
+        case 11:
+            DDRD  |= (1<<2);
+            PORTD &= ~(1<<3);
+            break;
+        case 12:
+            DDRD  |= (1<<3);
+            PORTD &= ~(1<<3);
+            break;
+        case 13:
+            DDRC  |= (1<<6);
+            PORTC &= ~(1<<6);
+            break;
     }
 }
 
@@ -74,6 +74,8 @@ OPT_DEFS += -DBOOTLOADER_SIZE=512
 SLEEP_LED_ENABLE = no
 API_SYSEX_ENABLE ?= no
 RGBLIGHT_ENABLE ?= yes
+# the matrix scan reads the left hand over interrupt driven I2C
+TWI_ASYNC_ENABLE = yes
 
 ifndef QUANTUM_DIR
 	include ../../../Makefile
@@ -1028,18 +1028,18 @@ void matrix_scan_user(void) {
 
 static uint16_t last4[4];
 
-const qk_ucis_symbol_t ucis_symbol_table[] = UCIS_TABLE
+UCIS_TABLE
 (
- UCIS_SYM("poop", 0x1f4a9),
- UCIS_SYM("rofl", 0x1f923),
- UCIS_SYM("kiss", 0x1f619),
- UCIS_SYM("snowman", 0x2603),
+ UCIS_SYM("bolt", 0x26a1),
  UCIS_SYM("coffee", 0x2615),
  UCIS_SYM("heart", 0x2764),
- UCIS_SYM("bolt", 0x26a1),
- UCIS_SYM("pi", 0x03c0),
- UCIS_SYM("mouse", 0x1f401),
+ UCIS_SYM("kiss", 0x1f619),
  UCIS_SYM("micro", 0x00b5),
+ UCIS_SYM("mouse", 0x1f401),
+ UCIS_SYM("pi", 0x03c0),
+ UCIS_SYM("poop", 0x1f4a9),
+ UCIS_SYM("rofl", 0x1f923),
+ UCIS_SYM("snowman", 0x2603),
  UCIS_SYM("tm", 0x2122)
 );
 
@@ -1 +1,13 @@
-#include "lets_split.h"
\ No newline at end of file
+#include "lets_split.h"
+#include "split_util.h"
+#include "pro_micro.h"
+
+void split_link_status_kb(bool connected) {
+    // turn on the indicator led when halves are disconnected
+    if (connected) {
+        TXLED0;
+    } else {
+        TXLED1;
+    }
+    split_link_status_user(connected);
+}
@@ -1,4 +1,5 @@
 #include "lets_split.h"
+#include "pro_micro.h"
 
 #ifdef AUDIO_ENABLE
     float tone_startup[][2] = SONG(STARTUP_SOUND);
@@ -6,6 +7,8 @@
 #endif
 
 void matrix_init_kb(void) {
+    // the TX LED shows when the halves are disconnected
+    TX_RX_LED_INIT;
 
     #ifdef AUDIO_ENABLE
         _delay_ms(20); // gets rid of tick
@@ -0,0 +1,183 @@
+#include "quantum.h"
+#include "async_macro.h"
+
+enum async_macro_type {
+  ASYNC_NONE = 0,
+  ASYNC_MACRO,
+  ASYNC_STRING,
+};
+
+typedef struct {
+  uint8_t type;
+  const uint8_t *data;
+} async_macro_entry_t;
+
+static async_macro_entry_t queue[ASYNC_MACRO_QUEUE_SIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_count = 0;
+
+static async_macro_entry_t current;
+static uint8_t interval = 0;
+// the key of the last typed character, it's released on the next step
+static uint8_t typed_keycode = 0;
+static bool typed_shift = false;
+// keys held down by the macro being played, released on cancel
+static uint8_t held[32];
+
+static deferred_t tick;
+
+static void async_macro_step(void *context);
+
+static bool queue_async(uint8_t type, const uint8_t *data) {
+  if (!data) {
+    return true;
+  }
+  if (queue_count == ASYNC_MACRO_QUEUE_SIZE) {
+    return false;
+  }
+  async_macro_entry_t *entry = &queue[(queue_head + queue_count) % ASYNC_MACRO_QUEUE_SIZE];
+  entry->type = type;
+  entry->data = data;
+  queue_count++;
+  if (!is_deferred_pending(&tick)) {
+    defer(&tick, 0, async_macro_step, NULL);
+  }
+  return true;
+}
+
+bool play_macro_async(const macro_t *macro) {
+  return queue_async(ASYNC_MACRO, macro);
+}
+
+bool send_string_async(const char *str) {
+  return queue_async(ASYNC_STRING, (const uint8_t *)str);
+}
+
+bool is_async_macro_playing(void) {
+  return current.type != ASYNC_NONE || queue_count;
+}
+
+static void press(uint8_t code) {
+  held[code / 8] |= 1 << (code % 8);
+  register_code(code);
+}
+
+static void release(uint8_t code) {
+  held[code / 8] &= ~(1 << (code % 8));
+  unregister_code(code);
+}
+
+static void release_typed(void) {
+  unregister_code(typed_keycode);
+  if (typed_shift) {
+    unregister_code(KC_LSFT);
+  }
+  typed_keycode = 0;
+  typed_shift = false;
+}
+
+void cancel_async_macros(void) {
+  cancel_deferred(&tick);
+  if (typed_keycode) {
+    release_typed();
+  }
+  for (uint8_t i = 0; i < sizeof(held); i++) {
+    for (uint8_t bit = 0; held[i]; bit++) {
+      if (held[i] & (1 << bit)) {
+        release(i * 8 + bit);
+      }
+    }
+  }
+  clear_macro_mods();
+  send_keyboard_report();
+  current.type = ASYNC_NONE;
+  queue_count = 0;
+}
+
+// Returns the delay before the next step, or -1 once the string is done
+static int16_t string_step(void) {
+  uint8_t ascii_code = pgm_read_byte(current.data);
+  if (!ascii_code) {
+    return -1;
+  }
+  current.data++;
+  typed_keycode = pgm_read_byte(&ascii_to_qwerty_keycode_lut[ascii_code]);
+  typed_shift = pgm_read_byte(&ascii_to_qwerty_shift_lut[ascii_code]);
+  if (typed_shift) {
+    register_code(KC_LSFT);
+  }
+  register_code(typed_keycode);
+  return 0;
+}
+
+// Same commands as action_macro_play(), one of them per step
+static int16_t macro_step(void) {
+  macro_t macro = MACRO_GET(current.data++);
+  uint16_t delay = interval;
+  switch (macro) {
+    case KEY_DOWN:
+      macro = MACRO_GET(current.data++);
+      if (IS_MOD(macro)) {
+        add_macro_mods(MOD_BIT(macro));
+        send_keyboard_report();
+      } else {
+        press(macro);
+      }
+      break;
+    case KEY_UP:
+      macro = MACRO_GET(current.data++);
+      if (IS_MOD(macro)) {
+        del_macro_mods(MOD_BIT(macro));
+        send_keyboard_report();
+      } else {
+        release(macro);
+      }
+      break;
+    case WAIT:
+      delay += MACRO_GET(current.data++);
+      break;
+    case INTERVAL:
+      interval = MACRO_GET(current.data++);
+      delay = interval;
+      break;
+    case 0x04 ... 0x73:
+      press(macro);
+      break;
+    case 0x84 ... 0xF3:
+      release(macro & 0x7F);
+      break;
+    case END:
+    default:
+      return -1;
+  }
+  return delay;
+}
+
+static void async_macro_step(void *context) {
+  int16_t delay = -1;
+
+  if (typed_keycode) {
+    release_typed();
+    delay = 0;
+  } else {
+    if (current.type == ASYNC_NONE) {
+      if (!queue_count) {
+        return;
+      }
+      current = queue[queue_head];
+      queue_head = (queue_head + 1) % ASYNC_MACRO_QUEUE_SIZE;
+      queue_count--;
+      interval = 0;
+    }
+    if (current.type == ASYNC_STRING) {
+      delay = string_step();
+    } else {
+      delay = macro_step();
+    }
+    if (delay < 0) {
+      current.type = ASYNC_NONE;
+      delay = 0;
+    }
+  }
+  defer(&tick, delay, async_macro_step, NULL);
+}
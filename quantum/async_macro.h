@@ -0,0 +1,33 @@
+#ifndef ASYNC_MACRO_H
+#define ASYNC_MACRO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "action_macro.h"
+
+/* Asynchronous macro playback
+ *
+ * MACRO() sequences and strings are queued here and played back one step
+ * per millisecond from the matrix scan, so the keyboard keeps scanning and
+ * the other keys keep working while a long macro is typed. Everything queued
+ * must live in PROGMEM, which MACRO() and SEND_STRING_ASYNC() take care of.
+ *
+ * Steps of queued macros interleave with the keys typed meanwhile, use the
+ * blocking action_macro_play() and send_string() where that matters.
+ */
+
+#ifndef ASYNC_MACRO_QUEUE_SIZE
+  #define ASYNC_MACRO_QUEUE_SIZE 8
+#endif
+
+#define SEND_STRING_ASYNC(str) send_string_async(PSTR(str))
+
+// These return false if the queue is full
+bool play_macro_async(const macro_t *macro);
+bool send_string_async(const char *str);
+
+// Stops playback, drops the queue and releases the keys a macro holds down
+void cancel_async_macros(void);
+bool is_async_macro_playing(void);
+
+#endif
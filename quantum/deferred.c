@@ -0,0 +1,58 @@
+#include "deferred.h"
+#include "timer.h"
+#include <stddef.h>
+
+static deferred_t *deferred_head = NULL;
+
+static void unlink_deferred(deferred_t *deferred) {
+  for (deferred_t **p = &deferred_head; *p; p = &(*p)->next) {
+    if (*p == deferred) {
+      *p = deferred->next;
+      break;
+    }
+  }
+  deferred->pending = false;
+}
+
+void defer(deferred_t *deferred, uint16_t delay, deferred_callback_t callback, void *context) {
+  if (deferred->pending) {
+    unlink_deferred(deferred);
+  }
+  deferred->deadline = timer_read32() + delay;
+  deferred->callback = callback;
+  deferred->context = context;
+
+  // keep the list sorted, equal deadlines run in the order they were added
+  deferred_t **p = &deferred_head;
+  while (*p && (int32_t)((*p)->deadline - deferred->deadline) <= 0) {
+    p = &(*p)->next;
+  }
+  deferred->next = *p;
+  *p = deferred;
+  deferred->pending = true;
+}
+
+void cancel_deferred(deferred_t *deferred) {
+  if (deferred->pending) {
+    unlink_deferred(deferred);
+  }
+}
+
+bool is_deferred_pending(const deferred_t *deferred) {
+  return deferred->pending;
+}
+
+void deferred_task(void) {
+  if (!deferred_head) {
+    return;
+  }
+  uint32_t now = timer_read32();
+  // strictly after the deadline, so something rescheduled with no delay
+  // from its callback waits for the next millisecond instead of looping here
+  while (deferred_head && (int32_t)(now - deferred_head->deadline) > 0) {
+    deferred_t *deferred = deferred_head;
+    deferred_head = deferred->next;
+    deferred->pending = false;
+    deferred->callback(deferred->context);
+  }
+}
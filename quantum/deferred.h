@@ -0,0 +1,38 @@
+#ifndef DEFERRED_H
+#define DEFERRED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Deferred execution
+ *
+ * Features that need to do something once a timeout passes schedule a
+ * callback here instead of checking their own timers on every matrix scan.
+ * Pending callbacks are kept sorted by deadline, so a scan with nothing due
+ * only compares the first deadline against the clock. Deadlines use the 32
+ * bit timer, so they don't become ambiguous after 65 seconds.
+ *
+ * The deferred_t is owned by the caller and usually lives next to the state
+ * it belongs to. Callbacks run from matrix_scan_quantum() and may schedule
+ * themselves again.
+ */
+
+typedef void (*deferred_callback_t)(void *context);
+
+typedef struct deferred {
+  uint32_t deadline;
+  deferred_callback_t callback;
+  void *context;
+  bool pending;
+  struct deferred *next;
+} deferred_t;
+
+// Runs callback(context) once more than delay ms have passed, a pending
+// deferred is rescheduled
+void defer(deferred_t *deferred, uint16_t delay, deferred_callback_t callback, void *context);
+void cancel_deferred(deferred_t *deferred);
+bool is_deferred_pending(const deferred_t *deferred);
+
+void deferred_task(void);
+
+#endif
@@ -0,0 +1,180 @@
+#include "quantum.h"
+#include "dynamic_keymap.h"
+#include "eeprom.h"
+#ifdef RAW_ENABLE
+#include "raw_hid.h"
+#endif
+
+#define DYNAMIC_KEYMAP_MAGIC 0xD7
+
+#define DYNAMIC_KEYMAP_KEYCODES_ADDR (DYNAMIC_KEYMAP_EEPROM_ADDR + 4)
+
+/* The addresses may depend on sizeof(), so these can't be #if checks. An
+ * error about a negative array size here means the keymap doesn't fit. */
+#ifdef __AVR__
+// DYNAMIC_KEYMAP_LAYER_COUNT layers must fit in the EEPROM
+typedef char dynamic_keymap_fits_eeprom[
+    DYNAMIC_KEYMAP_KEYCODES_ADDR + DYNAMIC_KEYMAP_SIZE <= E2END + 1 ? 1 : -1];
+#endif
+#ifdef DYNAMIC_MACRO_EEPROM
+// and must not overlap the saved dynamic macros
+typedef char dynamic_keymap_clear_of_macros[
+    DYNAMIC_KEYMAP_EEPROM_ADDR >= DYNAMIC_MACRO_EEPROM_END ||
+    DYNAMIC_KEYMAP_KEYCODES_ADDR + DYNAMIC_KEYMAP_SIZE <= DYNAMIC_MACRO_EEPROM_ADDR ? 1 : -1];
+#endif
+
+static uint16_t dynamic_keymap[DYNAMIC_KEYMAP_LAYER_COUNT][MATRIX_ROWS][MATRIX_COLS];
+
+static uint16_t *keycode_address(uint8_t layer, uint8_t row, uint8_t col) {
+  return (uint16_t *)(DYNAMIC_KEYMAP_KEYCODES_ADDR +
+                      ((layer * MATRIX_ROWS + row) * MATRIX_COLS + col) * 2);
+}
+
+static uint16_t default_keycode(uint8_t layer, uint8_t row, uint8_t col) {
+#ifdef SPARSE_KEYMAP_ENABLE
+  if (layer >= SPARSE_KEYMAP_LAYER) {
+    return sparse_keymap_key_to_keycode(layer, (keypos_t){ .row = row, .col = col });
+  }
+#endif
+  // never read past the layers keymaps[] has
+  if (layer >= keymaps_layer_count) {
+    return KC_TRNS;
+  }
+  return pgm_read_word(&keymaps[layer][row][col]);
+}
+
+void dynamic_keymap_reset(void) {
+  for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+      for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        uint16_t keycode = default_keycode(layer, row, col);
+        dynamic_keymap[layer][row][col] = keycode;
+        eeprom_update_word(keycode_address(layer, row, col), keycode);
+      }
+    }
+  }
+  const uint8_t header[4] = {
+    DYNAMIC_KEYMAP_MAGIC, DYNAMIC_KEYMAP_LAYER_COUNT, MATRIX_ROWS, MATRIX_COLS
+  };
+  eeprom_update_block(header, (void *)DYNAMIC_KEYMAP_EEPROM_ADDR, sizeof(header));
+}
+
+void dynamic_keymap_init(void) {
+  uint8_t header[4];
+  eeprom_read_block(header, (void *)DYNAMIC_KEYMAP_EEPROM_ADDR, sizeof(header));
+  if (header[0] != DYNAMIC_KEYMAP_MAGIC ||
+      header[1] != DYNAMIC_KEYMAP_LAYER_COUNT ||
+      header[2] != MATRIX_ROWS ||
+      header[3] != MATRIX_COLS) {
+    dynamic_keymap_reset();
+    return;
+  }
+  eeprom_read_block(dynamic_keymap, (void *)DYNAMIC_KEYMAP_KEYCODES_ADDR, sizeof(dynamic_keymap));
+}
+
+uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t col) {
+  if (layer >= DYNAMIC_KEYMAP_LAYER_COUNT || row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+    return KC_NO;
+  }
+  return dynamic_keymap[layer][row][col];
+}
+
+void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t col, uint16_t keycode) {
+  if (layer >= DYNAMIC_KEYMAP_LAYER_COUNT || row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+    return;
+  }
+  dynamic_keymap[layer][row][col] = keycode;
+  eeprom_update_word(keycode_address(layer, row, col), keycode);
+}
+
+void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
+  const uint16_t *keycodes = &dynamic_keymap[0][0][0];
+  for (uint16_t i = offset; i < offset + size && i < DYNAMIC_KEYMAP_SIZE; i++) {
+    uint16_t keycode = keycodes[i / 2];
+    *data++ = (i & 1) ? keycode & 0xFF : keycode >> 8;
+  }
+}
+
+void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, const uint8_t *data) {
+  uint16_t *keycodes = &dynamic_keymap[0][0][0];
+  uint16_t end = offset + size;
+  if (end > DYNAMIC_KEYMAP_SIZE) {
+    end = DYNAMIC_KEYMAP_SIZE;
+  }
+  for (uint16_t i = offset; i < end; i++) {
+    uint16_t *keycode = &keycodes[i / 2];
+    if (i & 1) {
+      *keycode = (*keycode & 0xFF00) | *data++;
+    } else {
+      *keycode = (*keycode & 0x00FF) | (*data++ << 8);
+    }
+  }
+  // one block update for the whole range, the EEPROM only stores what changed
+  uint16_t first = offset / 2;
+  uint16_t last = (end + 1) / 2;
+  if (first < last) {
+    eeprom_update_block(&keycodes[first],
+                        (void *)(DYNAMIC_KEYMAP_KEYCODES_ADDR + first * 2),
+                        (last - first) * 2);
+  }
+}
+
+#ifdef RAW_ENABLE
+
+__attribute__ ((weak))
+void raw_hid_receive_kb(uint8_t *data, uint8_t length) {
+  data[0] = id_unhandled;
+}
+
+void raw_hid_receive(uint8_t *data, uint8_t length) {
+  uint8_t *command_data = &data[1];
+  switch (data[0]) {
+    case id_get_protocol_version:
+      command_data[0] = DYNAMIC_KEYMAP_PROTOCOL_VERSION;
+      break;
+    case id_dynamic_keymap_get_layer_count:
+      command_data[0] = DYNAMIC_KEYMAP_LAYER_COUNT;
+      command_data[1] = MATRIX_ROWS;
+      command_data[2] = MATRIX_COLS;
+      break;
+    case id_dynamic_keymap_get_keycode: {
+      uint16_t keycode = dynamic_keymap_get_keycode(command_data[0], command_data[1], command_data[2]);
+      command_data[3] = keycode >> 8;
+      command_data[4] = keycode & 0xFF;
+      break;
+    }
+    case id_dynamic_keymap_set_keycode:
+      dynamic_keymap_set_keycode(command_data[0], command_data[1], command_data[2],
+                                 (command_data[3] << 8) | command_data[4]);
+      break;
+    case id_dynamic_keymap_get_buffer: {
+      uint16_t offset = (command_data[0] << 8) | command_data[1];
+      uint8_t size = command_data[2];
+      if (size > DYNAMIC_KEYMAP_BUFFER_CHUNK || size > length - 4) {
+        data[0] = id_unhandled;
+        break;
+      }
+      dynamic_keymap_get_buffer(offset, size, &command_data[3]);
+      break;
+    }
+    case id_dynamic_keymap_set_buffer: {
+      uint16_t offset = (command_data[0] << 8) | command_data[1];
+      uint8_t size = command_data[2];
+      if (size > DYNAMIC_KEYMAP_BUFFER_CHUNK || size > length - 4) {
+        data[0] = id_unhandled;
+        break;
+      }
+      dynamic_keymap_set_buffer(offset, size, &command_data[3]);
+      break;
+    }
+    case id_dynamic_keymap_reset:
+      dynamic_keymap_reset();
+      break;
+    default:
+      raw_hid_receive_kb(data, length);
+      break;
+  }
+  raw_hid_send(data, length);
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef DYNAMIC_KEYMAP_H
+#define DYNAMIC_KEYMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Dynamic keymap
+ *
+ * The first DYNAMIC_KEYMAP_LAYER_COUNT layers are stored in EEPROM and
+ * can be changed at runtime, over raw HID when RAW_ENABLE is set. They
+ * are copied to RAM at startup, so looking up a key costs no more than
+ * reading keymaps[]. The EEPROM is filled from keymaps[] the first time,
+ * whenever the matrix size changes, and on dynamic_keymap_reset().
+ *
+ * The EEPROM holds a four byte header followed by the keycodes, two bytes
+ * each, layer by layer and row by row.
+ */
+
+#ifndef DYNAMIC_KEYMAP_LAYER_COUNT
+#define DYNAMIC_KEYMAP_LAYER_COUNT 4
+#endif
+
+// Needs DYNAMIC_KEYMAP_SIZE + 4 bytes, right after the saved dynamic
+// macros when DYNAMIC_MACRO_EEPROM is used
+#ifdef DYNAMIC_MACRO_EEPROM
+#include "dynamic_macro_config.h"
+#endif
+#ifndef DYNAMIC_KEYMAP_EEPROM_ADDR
+#ifdef DYNAMIC_MACRO_EEPROM
+#define DYNAMIC_KEYMAP_EEPROM_ADDR DYNAMIC_MACRO_EEPROM_END
+#else
+#define DYNAMIC_KEYMAP_EEPROM_ADDR 64
+#endif
+#endif
+
+#define DYNAMIC_KEYMAP_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+
+/* keymaps[] is only known to keymap.c, which tells how many layers it has
+ * by putting this after it:
+ *
+ *   DYNAMIC_KEYMAP_DEFAULTS();
+ *
+ * Layers past them start out as KC_TRNS, sparse layers as listed in
+ * SPARSE_KEYMAP().
+ */
+#define DYNAMIC_KEYMAP_DEFAULTS() \
+  const uint8_t keymaps_layer_count = sizeof(keymaps) / sizeof(keymaps[0])
+extern const uint8_t keymaps_layer_count;
+
+void dynamic_keymap_init(void);
+void dynamic_keymap_reset(void);
+
+uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t col);
+void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t col, uint16_t keycode);
+
+/* Bulk access to the keymap as DYNAMIC_KEYMAP_SIZE bytes, keycodes are
+ * big endian. */
+void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data);
+void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, const uint8_t *data);
+
+#ifdef RAW_ENABLE
+/* Raw HID protocol
+ *
+ * Every report starts with the command id and is answered with a report
+ * echoing the request, with the requested data filled in. Unknown ids
+ * answer 0xFF in the first byte. A host doesn't have to wait for each
+ * answer, it can send the buffer writes for a whole layer back to back and
+ * read the answers afterwards.
+ *
+ *   get version       id -> id, DYNAMIC_KEYMAP_PROTOCOL_VERSION
+ *   get layer count   id -> id, DYNAMIC_KEYMAP_LAYER_COUNT, MATRIX_ROWS, MATRIX_COLS
+ *   get keycode       id, layer, row, col -> ..., keycode hi, keycode lo
+ *   set keycode       id, layer, row, col, keycode hi, keycode lo
+ *   get buffer        id, offset hi, offset lo, size -> ..., data
+ *   set buffer        id, offset hi, offset lo, size, data
+ *   reset             id
+ *
+ * The buffer commands move at most DYNAMIC_KEYMAP_BUFFER_CHUNK bytes.
+ */
+#define DYNAMIC_KEYMAP_PROTOCOL_VERSION 1
+
+enum dynamic_keymap_command_id {
+  id_get_protocol_version = 0x01,
+  id_dynamic_keymap_get_layer_count,
+  id_dynamic_keymap_get_keycode,
+  id_dynamic_keymap_set_keycode,
+  id_dynamic_keymap_get_buffer,
+  id_dynamic_keymap_set_buffer,
+  id_dynamic_keymap_reset,
+  id_unhandled = 0xFF,
+};
+
+#define DYNAMIC_KEYMAP_BUFFER_CHUNK 28
+
+// Handles the command ids this file doesn't know
+void raw_hid_receive_kb(uint8_t *data, uint8_t length);
+#endif
+
+#endif
@@ -3,18 +3,15 @@
 #define DYNAMIC_MACROS_H
 
 #include "action_layer.h"
+#include "dynamic_macro_config.h"
+#ifdef DYNAMIC_MACRO_EEPROM
+#include "eeprom.h"
+#endif
 
-#ifndef DYNAMIC_MACRO_SIZE
-/* May be overridden with a custom value. Be aware that the effective
- * macro length is half of this value: each keypress is recorded twice
- * because of the down-event and up-event. This is not a bug, it's the
- * intended behavior.
- *
- * Usually it should be fine to set the macro size to at least 256 but
- * there have been reports of it being too much in some users' cases,
- * so 128 is considered a safe default.
- */
-#define DYNAMIC_MACRO_SIZE 128
+#ifndef DYNAMIC_MACRO_MAX_DELAY
+/* Pauses longer than this are shortened on playback. Keep it above the
+ * tapping term so held keys are still played back as held. */
+#define DYNAMIC_MACRO_MAX_DELAY 1000
 #endif
 
 /* DYNAMIC_MACRO_RANGE must be set as the last element of user's
@@ -28,6 +25,25 @@ enum dynamic_macro_keycodes {
     DYN_MACRO_PLAY2,
 };
 
+/* Both macros use the same buffer but read/write on different ends of
+ * it, see process_record_dynamic_macro(). Macro2 is stored with the
+ * same byte order as macro1 but at decreasing addresses. */
+static uint8_t dynamic_macro_buffer[DYNAMIC_MACRO_BYTES];
+
+/* Index of the first byte after the first macro. */
+static uint16_t dynamic_macro_end = 0;
+
+/* Index of the first free byte below the second macro. */
+static uint16_t dynamic_macro_r_end = DYNAMIC_MACRO_BYTES - 1;
+
+/* The playback position, its direction, the index it stops at, the
+ * timer driving it and the layers to restore afterwards. */
+static uint16_t dynamic_macro_play_pos;
+static uint16_t dynamic_macro_play_end;
+static int8_t dynamic_macro_play_direction = 0;
+static deferred_t dynamic_macro_tick;
+static uint32_t dynamic_macro_saved_layer_state;
+
 /* Blink the LEDs to notify the user about some event. */
 void dynamic_macro_led_blink(void)
 {
@@ -36,64 +52,165 @@ void dynamic_macro_led_blink(void)
     backlight_toggle();
 }
 
+#ifdef DYNAMIC_MACRO_EEPROM
+static void dynamic_macro_save(void)
+{
+    uint16_t header[3] = {
+        DYNAMIC_MACRO_EEPROM_MAGIC, dynamic_macro_end, dynamic_macro_r_end
+    };
+    eeprom_update_block(header, (void *)DYNAMIC_MACRO_EEPROM_ADDR, sizeof(header));
+    eeprom_update_block(dynamic_macro_buffer,
+                        (void *)(DYNAMIC_MACRO_EEPROM_ADDR + sizeof(header)),
+                        sizeof(dynamic_macro_buffer));
+}
+
+static void dynamic_macro_load(void)
+{
+    uint16_t header[3];
+    eeprom_read_block(header, (void *)DYNAMIC_MACRO_EEPROM_ADDR, sizeof(header));
+    if (header[0] != DYNAMIC_MACRO_EEPROM_MAGIC ||
+        header[1] > (uint16_t)(header[2] + 1) ||
+        (uint16_t)(header[2] + 1) > DYNAMIC_MACRO_BYTES) {
+        return;
+    }
+    dynamic_macro_end = header[1];
+    dynamic_macro_r_end = header[2];
+    eeprom_read_block(dynamic_macro_buffer,
+                      (void *)(DYNAMIC_MACRO_EEPROM_ADDR + sizeof(header)),
+                      sizeof(dynamic_macro_buffer));
+}
+#endif
+
 /**
  * Start recording of the dynamic macro.
  *
  * @param[out] macro_pointer The new macro buffer iterator.
- * @param[in]  macro_buffer  The macro buffer used to initialize macro_pointer.
+ * @param[in]  macro_buffer  The index the macro starts at.
+ * @param[out] last_time     The time of the previous recorded event.
  */
 void dynamic_macro_record_start(
-    keyrecord_t **macro_pointer, keyrecord_t *macro_buffer)
+    uint16_t *macro_pointer, uint16_t macro_buffer, uint16_t *last_time)
 {
     dynamic_macro_led_blink();
 
     clear_keyboard();
     layer_clear();
     *macro_pointer = macro_buffer;
+    *last_time = timer_read();
+}
+
+/* Plays back the next event and schedules the one after it. */
+static void dynamic_macro_play_step(void *context)
+{
+    uint16_t pos = dynamic_macro_play_pos;
+    int8_t direction = dynamic_macro_play_direction;
+
+    if (pos == dynamic_macro_play_end) {
+        clear_keyboard();
+        layer_state = dynamic_macro_saved_layer_state;
+        dynamic_macro_play_direction = 0;
+        return;
+    }
+
+    uint8_t row = dynamic_macro_buffer[pos];
+    pos += direction;
+    uint8_t col = dynamic_macro_buffer[pos];
+    pos += direction;
+
+    action_exec((keyevent_t){
+        .key = (keypos_t){ .row = row & 0x7F, .col = col },
+        .pressed = row >> 7,
+        .time = (timer_read() | 1)
+    });
+
+    /* The delay before the next event. */
+    uint16_t delay = 0;
+    if (pos != dynamic_macro_play_end) {
+        uint8_t shift = 0;
+        uint8_t byte;
+        do {
+            byte = dynamic_macro_buffer[pos];
+            pos += direction;
+            delay |= (uint16_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+    }
+    dynamic_macro_play_pos = pos;
+    defer(&dynamic_macro_tick, delay, dynamic_macro_play_step, NULL);
 }
 
 /**
- * Play the dynamic macro.
+ * Play the dynamic macro. The events are played back from the matrix
+ * scan with their recorded timing, so the keyboard stays responsive. The
+ * layers are cleared for the playback and restored after it.
  *
- * @param macro_buffer[in] The beginning of the macro buffer being played.
- * @param macro_end[in]    The element after the last macro buffer element.
+ * @param macro_buffer[in] The index the macro starts at.
+ * @param macro_end[in]    The index after the last macro byte.
  * @param direction[in]    Either +1 or -1, which way to iterate the buffer.
  */
 void dynamic_macro_play(
-    keyrecord_t *macro_buffer, keyrecord_t *macro_end, int8_t direction)
+    uint16_t macro_buffer, uint16_t macro_end, int8_t direction)
 {
-    uint32_t saved_layer_state = layer_state;
+    dynamic_macro_saved_layer_state = layer_state;
 
     clear_keyboard();
     layer_clear();
 
-    while (macro_buffer != macro_end) {
-        process_record(macro_buffer);
-        macro_buffer += direction;
-    }
-
-    clear_keyboard();
-
-    layer_state = saved_layer_state;
+    dynamic_macro_play_pos = macro_buffer;
+    dynamic_macro_play_end = macro_end;
+    dynamic_macro_play_direction = direction;
+    dynamic_macro_play_step(NULL);
 }
 
 /**
  * Record a single key in a dynamic macro.
  *
+ * The time since the previous event is stored in front of every event
+ * but the first, so playback knows how long to wait before it.
+ *
  * @param macro_pointer[in,out] The current buffer position.
+ * @param macro_start[in]       The index the macro starts at.
  * @param macro_end2[in] The end of the other macro which shouldn't be overwritten.
  * @param direction[in]  Either +1 or -1, which way to iterate the buffer.
+ * @param last_time[in,out] The time of the previous recorded event.
  * @param record[in]     The current keypress.
  */
 void dynamic_macro_record_key(
-    keyrecord_t **macro_pointer,
-    keyrecord_t *macro_end2,
+    uint16_t *macro_pointer,
+    uint16_t macro_start,
+    uint16_t macro_end2,
     int8_t direction,
+    uint16_t *last_time,
     keyrecord_t *record)
 {
-    if (*macro_pointer + direction != macro_end2) {
-        **macro_pointer = *record;
-        *macro_pointer += direction;
+    uint8_t event[5];
+    uint8_t length = 0;
+
+    if (*macro_pointer != macro_start) {
+        uint16_t delay = TIMER_DIFF_16(record->event.time, *last_time);
+        if (delay > DYNAMIC_MACRO_MAX_DELAY) {
+            delay = DYNAMIC_MACRO_MAX_DELAY;
+        }
+        while (delay > 0x7F) {
+            event[length++] = (delay & 0x7F) | 0x80;
+            delay >>= 7;
+        }
+        event[length++] = delay;
+    }
+    event[length++] = (record->event.pressed ? 0x80 : 0) | record->event.key.row;
+    event[length++] = record->event.key.col;
+
+    /* The free space is everything between the two macros, macro_end2
+     * included when recording macro1 and excluded for macro2. */
+    uint16_t free = direction > 0
+        ? macro_end2 + 1 - *macro_pointer
+        : *macro_pointer - macro_end2 + 1;
+    if (length <= free) {
+        for (uint8_t i = 0; i < length; i++) {
+            dynamic_macro_buffer[*macro_pointer] = event[i];
+            *macro_pointer += direction;
+        }
+        *last_time = record->event.time;
     } else {
         /* Notify about the end of buffer. The blinks are paired
          * because they should happen on both down and up events. */
@@ -105,11 +222,14 @@ void dynamic_macro_record_key(
  * End recording of the dynamic macro. Essentially just update the
  * pointer to the end of the macro.
  */
-void dynamic_macro_record_end(keyrecord_t *macro_pointer, keyrecord_t **macro_end)
+void dynamic_macro_record_end(uint16_t macro_pointer, uint16_t *macro_end)
 {
     dynamic_macro_led_blink();
 
     *macro_end = macro_pointer;
+#ifdef DYNAMIC_MACRO_EEPROM
+    dynamic_macro_save();
+#endif
 }
 
 /* Handle the key events related to the dynamic macros. Should be
@@ -133,13 +253,13 @@ bool process_record_dynamic_macro(uint16_t keycode, keyrecord_t *record)
      * Macro2 is written right-to-left starting from the end of the
      * buffer.
      *
-     * &macro_buffer   macro_end
-     *  v                   v
+     * 0      dynamic_macro_end
+     * v                    v
      * +------------------------------------------------------------+
      * |>>>>>> MACRO1 >>>>>>|    |<<<<<<<<<<<<< MACRO2 <<<<<<<<<<<<<|
      * +------------------------------------------------------------+
-     *                           ^                                 ^
-     *                         r_macro_end                  r_macro_buffer
+     *                          ^                                  ^
+     *                 dynamic_macro_r_end         DYNAMIC_MACRO_BYTES - 1
      *
      * During the recording when one macro encounters the end of the
      * other macro, the recording is stopped. Apart from this, there
@@ -148,45 +268,51 @@ bool process_record_dynamic_macro(uint16_t keycode, keyrecord_t *record)
      * macros or one long macro and one short macro. Or even one empty
      * and one using the whole buffer.
      */
-    static keyrecord_t macro_buffer[DYNAMIC_MACRO_SIZE];
-
-    /* Pointer to the first buffer element after the first macro.
-     * Initially points to the very beginning of the buffer since the
-     * macro is empty. */
-    static keyrecord_t *macro_end = macro_buffer;
-
-    /* The other end of the macro buffer. Serves as the beginning of
-     * the second macro. */
-    static keyrecord_t *const r_macro_buffer = macro_buffer + DYNAMIC_MACRO_SIZE - 1;
-
-    /* Like macro_end but for the second macro. */
-    static keyrecord_t *r_macro_end = r_macro_buffer;
 
     /* A persistent pointer to the current macro position (iterator)
-     * used during the recording. */
-    static keyrecord_t *macro_pointer = NULL;
+     * used during the recording, and the time of the last event. */
+    static uint16_t macro_pointer = 0;
+    static uint16_t last_time = 0;
 
     /* 0   - no macro is being recorded right now
      * 1,2 - either macro 1 or 2 is being recorded */
     static uint8_t macro_id = 0;
 
+#ifdef DYNAMIC_MACRO_EEPROM
+    static bool loaded = false;
+    if (!loaded) {
+        dynamic_macro_load();
+        loaded = true;
+    }
+#endif
+
     if (macro_id == 0) {
+        /* Ignore the macro keys while a macro is being played back. */
+        if (dynamic_macro_play_direction != 0) {
+            switch (keycode) {
+            case DYN_REC_START1:
+            case DYN_REC_START2:
+            case DYN_MACRO_PLAY1:
+            case DYN_MACRO_PLAY2:
+                return false;
+            }
+        }
         /* No macro recording in progress. */
         if (!record->event.pressed) {
             switch (keycode) {
             case DYN_REC_START1:
-                dynamic_macro_record_start(&macro_pointer, macro_buffer);
+                dynamic_macro_record_start(&macro_pointer, 0, &last_time);
                 macro_id = 1;
                 return false;
             case DYN_REC_START2:
-                dynamic_macro_record_start(&macro_pointer, r_macro_buffer);
+                dynamic_macro_record_start(&macro_pointer, DYNAMIC_MACRO_BYTES - 1, &last_time);
                 macro_id = 2;
                 return false;
             case DYN_MACRO_PLAY1:
-                dynamic_macro_play(macro_buffer, macro_end, +1);
+                dynamic_macro_play(0, dynamic_macro_end, +1);
                 return false;
             case DYN_MACRO_PLAY2:
-                dynamic_macro_play(r_macro_buffer, r_macro_end, -1);
+                dynamic_macro_play(DYNAMIC_MACRO_BYTES - 1, dynamic_macro_r_end, -1);
                 return false;
             }
         }
@@ -201,10 +327,10 @@ bool process_record_dynamic_macro(uint16_t keycode, keyrecord_t *record)
                                           * starts. */
                 switch (macro_id) {
                 case 1:
-                    dynamic_macro_record_end(macro_pointer, &macro_end);
+                    dynamic_macro_record_end(macro_pointer, &dynamic_macro_end);
                     break;
                 case 2:
-                    dynamic_macro_record_end(macro_pointer, &r_macro_end);
+                    dynamic_macro_record_end(macro_pointer, &dynamic_macro_r_end);
                     break;
                 }
                 macro_id = 0;
@@ -214,10 +340,10 @@ bool process_record_dynamic_macro(uint16_t keycode, keyrecord_t *record)
             /* Store the key in the macro buffer and process it normally. */
             switch (macro_id) {
             case 1:
-                dynamic_macro_record_key(&macro_pointer, r_macro_end, +1, record);
+                dynamic_macro_record_key(&macro_pointer, 0, dynamic_macro_r_end, +1, &last_time, record);
                 break;
             case 2:
-                dynamic_macro_record_key(&macro_pointer, macro_end, -1, record);
+                dynamic_macro_record_key(&macro_pointer, DYNAMIC_MACRO_BYTES - 1, dynamic_macro_end, -1, &last_time, record);
                 break;
             }
             return true;
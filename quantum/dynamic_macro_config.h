@@ -0,0 +1,44 @@
+#ifndef DYNAMIC_MACRO_CONFIG_H
+#define DYNAMIC_MACRO_CONFIG_H
+
+/* Sizes and EEPROM layout of the dynamic macros. Kept apart from
+ * dynamic_macro.h, which only the keymap can include, so other features
+ * that store data in the EEPROM can stay clear of the macros. */
+
+#include "action.h"
+
+#ifndef DYNAMIC_MACRO_SIZE
+/* May be overridden with a custom value. This used to be the number of
+ * stored key events and is kept for existing configs: the buffer takes
+ * as much RAM as that many keyrecord_t did, see DYNAMIC_MACRO_BYTES. Be
+ * aware that each keypress is recorded twice because of the down-event
+ * and up-event. This is not a bug, it's the intended behavior.
+ *
+ * Usually it should be fine to set the macro size to at least 256 but
+ * there have been reports of it being too much in some users' cases,
+ * so 128 is considered a safe default.
+ */
+#define DYNAMIC_MACRO_SIZE 128
+#endif
+
+#ifndef DYNAMIC_MACRO_BYTES
+/* The events are stored as the key position with the press bit (two
+ * bytes) followed by the time since the previous event as a varint (one
+ * byte below 128ms, two above), so this fits two to three times as many
+ * events as DYNAMIC_MACRO_SIZE. */
+#define DYNAMIC_MACRO_BYTES (DYNAMIC_MACRO_SIZE * sizeof(keyrecord_t))
+#endif
+
+#ifdef DYNAMIC_MACRO_EEPROM
+/* With DYNAMIC_MACRO_EEPROM defined the macros are saved whenever a
+ * recording ends and survive power-off. They take DYNAMIC_MACRO_BYTES
+ * plus six bytes of EEPROM starting at this address. */
+#ifndef DYNAMIC_MACRO_EEPROM_ADDR
+#define DYNAMIC_MACRO_EEPROM_ADDR 32
+#endif
+#define DYNAMIC_MACRO_EEPROM_MAGIC 0xD14C
+/* first byte after the saved macros */
+#define DYNAMIC_MACRO_EEPROM_END (DYNAMIC_MACRO_EEPROM_ADDR + 6 + DYNAMIC_MACRO_BYTES)
+#endif
+
+#endif
@@ -49,5 +49,44 @@ uint16_t keymap_function_id_to_action( uint16_t function_id );
 extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
 extern const uint16_t fn_actions[];
 
+#ifdef SPARSE_KEYMAP_ENABLE
+/* Sparse layers
+ *
+ * Layers from SPARSE_KEYMAP_LAYER up are not stored in keymaps[], only
+ * their non-transparent keys are, in one sorted list:
+ *
+ *   SPARSE_KEYMAP(
+ *     SPARSE_KEY(3, 0, 1, KC_F1),
+ *     SPARSE_KEY(3, 0, 2, KC_F2),
+ *     SPARSE_KEY(4, 2, 0, KC_MPLY),
+ *   );
+ *
+ * The keys have to be listed by layer, then row, then column. Every key
+ * takes four bytes of flash, and anything not listed is KC_TRNS.
+ */
+#ifndef SPARSE_KEYMAP_LAYER
+#   error "SPARSE_KEYMAP_LAYER must be set to the first sparse layer"
+#endif
+#if MATRIX_ROWS * MATRIX_COLS > 256
+#   error "sparse layers need a matrix of at most 256 keys"
+#endif
+
+typedef struct {
+    uint16_t position;
+    uint16_t keycode;
+} sparse_key_t;
+
+#define SPARSE_KEY(layer, row, col, kc) { ((layer) << 8) | ((row) * MATRIX_COLS + (col)), (kc) }
+#define SPARSE_KEYMAP(...) \
+    const sparse_key_t sparse_keymap[] PROGMEM = { __VA_ARGS__ }; \
+    const uint16_t sparse_keymap_size = sizeof(sparse_keymap) / sizeof(sparse_keymap[0])
+
+extern const sparse_key_t sparse_keymap[];
+extern const uint16_t sparse_keymap_size;
+
+/* keycode of a key on a sparse layer */
+uint16_t sparse_keymap_key_to_keycode(uint8_t layer, keypos_t key);
+#endif
+
 
 #endif
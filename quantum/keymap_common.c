@@ -37,6 +37,62 @@ extern keymap_config_t keymap_config;
 
 #include <inttypes.h>
 
+/* Keycode kinds for action_for_key(). The high byte of a keycode picks
+ * the quantum range it belongs to, and for basic keycodes the low byte
+ * picks the kind, so the translation below is two table reads and a jump
+ * table instead of a chain of range comparisons.
+ */
+enum keycode_kind {
+    KIND_NO = 0,
+    KIND_BASIC,
+    KIND_KEY,
+    KIND_FN,
+    KIND_SYSTEM,
+    KIND_CONSUMER,
+    KIND_MOUSEKEY,
+    KIND_TRNS,
+    KIND_MODS,
+    KIND_FUNCTION,
+    KIND_MACRO,
+    KIND_LAYER_TAP,
+    KIND_TO,
+    KIND_MOMENTARY,
+    KIND_DEF_LAYER,
+    KIND_TOGGLE_LAYER,
+    KIND_ONE_SHOT_LAYER,
+    KIND_ONE_SHOT_MOD,
+    KIND_LAYER_TAP_TOGGLE,
+    KIND_MOD_TAP,
+    KIND_QUANTUM,
+};
+
+static const uint8_t keycode_kind_high[(QK_MOD_TAP_MAX >> 8) + 1] PROGMEM = {
+    [QK_TMK >> 8]                                           = KIND_BASIC,
+    [QK_MODS >> 8 ... QK_MODS_MAX >> 8]                     = KIND_MODS,
+    [QK_FUNCTION >> 8 ... QK_FUNCTION_MAX >> 8]             = KIND_FUNCTION,
+    [QK_MACRO >> 8 ... QK_MACRO_MAX >> 8]                   = KIND_MACRO,
+    [QK_LAYER_TAP >> 8 ... QK_LAYER_TAP_MAX >> 8]           = KIND_LAYER_TAP,
+    [QK_TO >> 8]                                            = KIND_TO,
+    [QK_MOMENTARY >> 8]                                     = KIND_MOMENTARY,
+    [QK_DEF_LAYER >> 8]                                     = KIND_DEF_LAYER,
+    [QK_TOGGLE_LAYER >> 8]                                  = KIND_TOGGLE_LAYER,
+    [QK_ONE_SHOT_LAYER >> 8]                                = KIND_ONE_SHOT_LAYER,
+    [QK_ONE_SHOT_MOD >> 8]                                  = KIND_ONE_SHOT_MOD,
+    [QK_LAYER_TAP_TOGGLE >> 8]                              = KIND_LAYER_TAP_TOGGLE,
+    [RESET >> 8 ... (QK_MOD_TAP >> 8) - 1]                  = KIND_QUANTUM,
+    [QK_MOD_TAP >> 8 ... QK_MOD_TAP_MAX >> 8]               = KIND_MOD_TAP,
+};
+
+static const uint8_t keycode_kind_basic[QK_TMK_MAX + 1] PROGMEM = {
+    [KC_TRNS]                               = KIND_TRNS,
+    [KC_A ... KC_EXSEL]                     = KIND_KEY,
+    [KC_SYSTEM_POWER ... KC_SYSTEM_WAKE]    = KIND_SYSTEM,
+    [KC_AUDIO_MUTE ... KC_MEDIA_REWIND]     = KIND_CONSUMER,
+    [KC_FN0 ... KC_FN31]                    = KIND_FN,
+    [KC_LCTRL ... KC_RGUI]                  = KIND_KEY,
+    [KC_MS_UP ... KC_MS_ACCEL2]             = KIND_MOUSEKEY,
+};
+
 /* converts key to action */
 action_t action_for_key(uint8_t layer, keypos_t key)
 {
@@ -49,99 +105,115 @@ action_t action_for_key(uint8_t layer, keypos_t key)
     action_t action;
     uint8_t action_layer, when, mod;
 
-    switch (keycode) {
-        case KC_FN0 ... KC_FN31:
+    uint8_t kind = KIND_NO;
+    if (keycode <= QK_MOD_TAP_MAX) {
+        kind = pgm_read_byte(&keycode_kind_high[keycode >> 8]);
+        if (kind == KIND_BASIC) {
+            kind = pgm_read_byte(&keycode_kind_basic[keycode]);
+        }
+    }
+
+    switch (kind) {
+        case KIND_FN:
             action.code = keymap_function_id_to_action(FN_INDEX(keycode));
             break;
-        case KC_A ... KC_EXSEL:
-        case KC_LCTRL ... KC_RGUI:
+        case KIND_KEY:
             action.code = ACTION_KEY(keycode);
             break;
-        case KC_SYSTEM_POWER ... KC_SYSTEM_WAKE:
+        case KIND_SYSTEM:
             action.code = ACTION_USAGE_SYSTEM(KEYCODE2SYSTEM(keycode));
             break;
-        case KC_AUDIO_MUTE ... KC_MEDIA_REWIND:
+        case KIND_CONSUMER:
             action.code = ACTION_USAGE_CONSUMER(KEYCODE2CONSUMER(keycode));
             break;
-        case KC_MS_UP ... KC_MS_ACCEL2:
+        case KIND_MOUSEKEY:
             action.code = ACTION_MOUSEKEY(keycode);
             break;
-        case KC_TRNS:
+        case KIND_TRNS:
             action.code = ACTION_TRANSPARENT;
             break;
-        case QK_MODS ... QK_MODS_MAX: ;
+        case KIND_MODS:
             // Has a modifier
             // Split it up
             action.code = ACTION_MODS_KEY(keycode >> 8, keycode & 0xFF); // adds modifier to key
             break;
-        case QK_FUNCTION ... QK_FUNCTION_MAX: ;
+        case KIND_FUNCTION:
             // Is a shortcut for function action_layer, pull last 12bits
             // This means we have 4,096 FN macros at our disposal
             action.code = keymap_function_id_to_action( (int)keycode & 0xFFF );
             break;
-        case QK_MACRO ... QK_MACRO_MAX:
+        case KIND_MACRO:
             if (keycode & 0x800) // tap macros have upper bit set
                 action.code = ACTION_MACRO_TAP(keycode & 0xFF);
             else
                 action.code = ACTION_MACRO(keycode & 0xFF);
             break;
-        case QK_LAYER_TAP ... QK_LAYER_TAP_MAX:
+        case KIND_LAYER_TAP:
             action.code = ACTION_LAYER_TAP_KEY((keycode >> 0x8) & 0xF, keycode & 0xFF);
             break;
-        case QK_TO ... QK_TO_MAX: ;
+        case KIND_TO:
             // Layer set "GOTO"
             when = (keycode >> 0x4) & 0x3;
             action_layer = keycode & 0xF;
             action.code = ACTION_LAYER_SET(action_layer, when);
             break;
-        case QK_MOMENTARY ... QK_MOMENTARY_MAX: ;
+        case KIND_MOMENTARY:
             // Momentary action_layer
             action_layer = keycode & 0xFF;
             action.code = ACTION_LAYER_MOMENTARY(action_layer);
             break;
-        case QK_DEF_LAYER ... QK_DEF_LAYER_MAX: ;
+        case KIND_DEF_LAYER:
             // Set default action_layer
             action_layer = keycode & 0xFF;
             action.code = ACTION_DEFAULT_LAYER_SET(action_layer);
             break;
-        case QK_TOGGLE_LAYER ... QK_TOGGLE_LAYER_MAX: ;
+        case KIND_TOGGLE_LAYER:
             // Set toggle
             action_layer = keycode & 0xFF;
             action.code = ACTION_LAYER_TOGGLE(action_layer);
             break;
-        case QK_ONE_SHOT_LAYER ... QK_ONE_SHOT_LAYER_MAX: ;
+        case KIND_ONE_SHOT_LAYER:
             // OSL(action_layer) - One-shot action_layer
             action_layer = keycode & 0xFF;
             action.code = ACTION_LAYER_ONESHOT(action_layer);
             break;
-        case QK_ONE_SHOT_MOD ... QK_ONE_SHOT_MOD_MAX: ;
+        case KIND_ONE_SHOT_MOD:
             // OSM(mod) - One-shot mod
             mod = keycode & 0xFF;
             action.code = ACTION_MODS_ONESHOT(mod);
             break;
-        case QK_LAYER_TAP_TOGGLE ... QK_LAYER_TAP_TOGGLE_MAX:
+        case KIND_LAYER_TAP_TOGGLE:
             action.code = ACTION_LAYER_TAP_TOGGLE(keycode & 0xFF);
             break;
-        case QK_MOD_TAP ... QK_MOD_TAP_MAX:
+        case KIND_MOD_TAP:
             action.code = ACTION_MODS_TAP_KEY((keycode >> 0x8) & 0x1F, keycode & 0xFF);
             break;
-    #ifdef BACKLIGHT_ENABLE
-        case BL_0 ... BL_15:
-            action.code = ACTION_BACKLIGHT_LEVEL(keycode - BL_0);
-            break;
-        case BL_DEC:
-            action.code = ACTION_BACKLIGHT_DECREASE();
-            break;
-        case BL_INC:
-            action.code = ACTION_BACKLIGHT_INCREASE();
-            break;
-        case BL_TOGG:
-            action.code = ACTION_BACKLIGHT_TOGGLE();
+        case KIND_QUANTUM:
+            // the remaining quantum keycodes are handled in
+            // process_record_quantum(), only backlight has actions
+            switch (keycode) {
+            #ifdef BACKLIGHT_ENABLE
+                case BL_0 ... BL_15:
+                    action.code = ACTION_BACKLIGHT_LEVEL(keycode - BL_0);
+                    break;
+                case BL_DEC:
+                    action.code = ACTION_BACKLIGHT_DECREASE();
+                    break;
+                case BL_INC:
+                    action.code = ACTION_BACKLIGHT_INCREASE();
+                    break;
+                case BL_TOGG:
+                    action.code = ACTION_BACKLIGHT_TOGGLE();
+                    break;
+                case BL_STEP:
+                    action.code = ACTION_BACKLIGHT_STEP();
+                    break;
+            #endif
+                default:
+                    action.code = ACTION_NO;
+                    break;
+            }
             break;
-        case BL_STEP:
-            action.code = ACTION_BACKLIGHT_STEP();
-            break;
-    #endif
         default:
             action.code = ACTION_NO;
             break;
@@ -167,10 +239,42 @@ void action_function(keyrecord_t *record, uint8_t id, uint8_t opt)
 {
 }
 
+#ifdef SPARSE_KEYMAP_ENABLE
+uint16_t sparse_keymap_key_to_keycode(uint8_t layer, keypos_t key)
+{
+    // binary search of the sorted sparse keys
+    uint16_t position = (layer << 8) | (key.row * MATRIX_COLS + key.col);
+    uint16_t low = 0;
+    uint16_t high = sparse_keymap_size;
+    while (low < high) {
+        uint16_t middle = (low + high) / 2;
+        uint16_t middle_position = pgm_read_word(&sparse_keymap[middle].position);
+        if (middle_position == position) {
+            return pgm_read_word(&sparse_keymap[middle].keycode);
+        } else if (middle_position < position) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return KC_TRNS;
+}
+#endif
+
 // translates key to keycode
 __attribute__ ((weak))
 uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key)
 {
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    if (layer < DYNAMIC_KEYMAP_LAYER_COUNT) {
+        return dynamic_keymap_get_keycode(layer, key.row, key.col);
+    }
+#endif
+#ifdef SPARSE_KEYMAP_ENABLE
+    if (layer >= SPARSE_KEYMAP_LAYER) {
+        return sparse_keymap_key_to_keycode(layer, key);
+    }
+#endif
     // Read entire word (16bits)
     return pgm_read_word(&keymaps[(layer)][(key.row)][(key.col)]);
 }
@@ -54,6 +54,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    define print_matrix_row(row)  print_bin_reverse32(matrix_get_row(row))
 #    define matrix_bitpop(i)       bitpop32(matrix[i])
 #    define ROW_SHIFTER  ((uint32_t)1)
+#else
+/* a row is a single matrix_row_t here, see MATRIX_ROW_WORDS in matrix.h */
+#    error "quantum/matrix.c: MATRIX_COLS > 32 needs a custom matrix"
 #endif
 
 #ifdef MATRIX_MASKED
@@ -63,6 +66,33 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #if (DIODE_DIRECTION == ROW2COL) || (DIODE_DIRECTION == COL2ROW)
 static const uint8_t row_pins[MATRIX_ROWS] = MATRIX_ROW_PINS;
 static const uint8_t col_pins[MATRIX_COLS] = MATRIX_COL_PINS;
+
+/* Pins that are read together: consecutive pins of one port that map to
+ * consecutive bits of the result. Reading a row takes one register read per
+ * port and one shift and mask per run instead of a lookup per pin.
+ */
+typedef struct {
+    uint8_t port;   // I/O address of the PINx register
+    uint8_t mask;   // pins of the run, shifted down to bit 0
+    uint8_t pin;    // first pin of the run
+    uint8_t bit;    // where the first pin goes in the result
+} pin_run_t;
+
+#if (DIODE_DIRECTION == COL2ROW)
+typedef matrix_row_t pin_bits_t;
+static pin_run_t col_runs[MATRIX_COLS];
+static uint8_t col_run_count;
+#else
+#   if (MATRIX_ROWS <= 8)
+typedef uint8_t pin_bits_t;
+#   elif (MATRIX_ROWS <= 16)
+typedef uint16_t pin_bits_t;
+#   else
+typedef uint32_t pin_bits_t;
+#   endif
+static pin_run_t row_runs[MATRIX_ROWS];
+static uint8_t row_run_count;
+#endif
 #endif
 
 /* matrix state(1:on, 0:off) */
@@ -273,6 +303,65 @@ uint8_t matrix_key_count(void)
 
 
 
+#if (DIODE_DIRECTION == ROW2COL) || (DIODE_DIRECTION == COL2ROW)
+
+/* Groups the pins into runs, sorted by port so each port is read once */
+static uint8_t init_pin_runs(const uint8_t pins[], uint8_t count, pin_run_t runs[])
+{
+    uint8_t run_count = 0;
+    uint8_t length = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t port = pins[i] >> 4;
+        uint8_t pin = pins[i] & 0xF;
+        pin_run_t *run;
+
+        if (run_count) {
+            run = &runs[run_count - 1];
+            if (run->port == port && run->pin + length == pin) {
+                run->mask |= 1 << length;
+                length++;
+                continue;
+            }
+        }
+        run = &runs[run_count++];
+        run->port = port;
+        run->mask = 1;
+        run->pin = pin;
+        run->bit = i;
+        length = 1;
+    }
+
+    for (uint8_t i = 1; i < run_count; i++) {
+        pin_run_t run = runs[i];
+        uint8_t j = i;
+        for (; j > 0 && runs[j - 1].port > run.port; j--) {
+            runs[j] = runs[j - 1];
+        }
+        runs[j] = run;
+    }
+    return run_count;
+}
+
+/* Returns a bit per pin, set when the pin is low */
+static pin_bits_t read_pin_runs(const pin_run_t runs[], uint8_t run_count)
+{
+    pin_bits_t bits = 0;
+    uint8_t port = 0xFF;
+    uint8_t state = 0;
+
+    for (uint8_t i = 0; i < run_count; i++) {
+        if (runs[i].port != port) {
+            port = runs[i].port;
+            state = ~_SFR_IO8(port);
+        }
+        bits |= (pin_bits_t)((state >> runs[i].pin) & runs[i].mask) << runs[i].bit;
+    }
+    return bits;
+}
+
+#endif
+
 #if (DIODE_DIRECTION == COL2ROW)
 
 static void init_cols(void)
@@ -282,6 +371,7 @@ static void init_cols(void)
         _SFR_IO8((pin >> 4) + 1) &= ~_BV(pin & 0xF); // IN
         _SFR_IO8((pin >> 4) + 2) |=  _BV(pin & 0xF); // HI
     }
+    col_run_count = init_pin_runs(col_pins, MATRIX_COLS, col_runs);
 }
 
 static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row)
@@ -289,23 +379,12 @@ static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row)
     // Store last value of row prior to reading
     matrix_row_t last_row_value = current_matrix[current_row];
 
-    // Clear data in matrix row
-    current_matrix[current_row] = 0;
-
     // Select row and wait for row selecton to stabilize
     select_row(current_row);
     wait_us(30);
 
-    // For each col...
-    for(uint8_t col_index = 0; col_index < MATRIX_COLS; col_index++) {
-
-        // Select the col pin to read (active low)
-        uint8_t pin = col_pins[col_index];
-        uint8_t pin_state = (_SFR_IO8(pin >> 4) & _BV(pin & 0xF));
-
-        // Populate the matrix row with the state of the col pin
-        current_matrix[current_row] |=  pin_state ? 0 : (ROW_SHIFTER << col_index);
-    }
+    // Populate the matrix row with the state of the col pins (active low)
+    current_matrix[current_row] = read_pin_runs(col_runs, col_run_count);
 
     // Unselect row
     unselect_row(current_row);
@@ -345,6 +424,7 @@ static void init_rows(void)
         _SFR_IO8((pin >> 4) + 1) &= ~_BV(pin & 0xF); // IN
         _SFR_IO8((pin >> 4) + 2) |=  _BV(pin & 0xF); // HI
     }
+    row_run_count = init_pin_runs(row_pins, MATRIX_ROWS, row_runs);
 }
 
 static bool read_rows_on_col(matrix_row_t current_matrix[], uint8_t current_col)
@@ -355,6 +435,9 @@ static bool read_rows_on_col(matrix_row_t current_matrix[], uint8_t current_col)
     select_col(current_col);
     wait_us(30);
 
+    // Read the state of all row pins (active low)
+    pin_bits_t rows = read_pin_runs(row_runs, row_run_count);
+
     // For each row...
     for(uint8_t row_index = 0; row_index < MATRIX_ROWS; row_index++)
     {
@@ -363,7 +446,7 @@ static bool read_rows_on_col(matrix_row_t current_matrix[], uint8_t current_col)
         matrix_row_t last_row_value = current_matrix[row_index];
 
         // Check row pin state
-        if ((_SFR_IO8(row_pins[row_index] >> 4) & _BV(row_pins[row_index] & 0xF)) == 0)
+        if (rows & ((pin_bits_t)1 << row_index))
         {
             // Pin LO, set col bit
             current_matrix[row_index] |= (ROW_SHIFTER << current_col);
@@ -2,9 +2,6 @@
 #include "print.h"
 
 
-#define COMBO_TIMER_ELAPSED -1
-
-
 __attribute__ ((weak))
 combo_t key_combos[] = {
 
@@ -30,6 +27,31 @@ static inline void send_combo(uint16_t action, bool pressed)
     }
 }
 
+static void combo_timeout(void *context)
+{
+    combo_t *combo = (combo_t *)context;
+
+    /* This disables the combo, meaning key events for this
+     * combo will be handled by the next processors in the chain
+     */
+    combo->disabled = true;
+
+#ifdef COMBO_ALLOW_ACTION_KEYS
+    process_action(&combo->prev_record,
+        store_or_get_action(combo->prev_record.event.pressed,
+                            combo->prev_record.event.key));
+#else
+    unregister_code16(combo->prev_key);
+    register_code16(combo->prev_key);
+#endif
+}
+
+static inline void reset_combo(combo_t *combo)
+{
+    cancel_deferred(&combo->timeout);
+    combo->disabled = false;
+}
+
 #define ALL_COMBO_KEYS_ARE_DOWN     (((1<<count)-1) == combo->state)
 #define NO_COMBO_KEYS_ARE_DOWN      (0 == combo->state)
 #define KEY_STATE_DOWN(key)         do{ combo->state |= (1<<key); } while(0)
@@ -48,8 +70,7 @@ static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *
     /* Return if not a combo key */
     if (-1 == (int8_t)index) return false;
 
-    /* The combos timer is used to signal whether the combo is active */
-    bool is_combo_active = COMBO_TIMER_ELAPSED == combo->timer ? false : true;
+    bool is_combo_active = !combo->disabled;
 
     if (record->event.pressed) {
         KEY_STATE_DOWN(index);
@@ -57,9 +78,10 @@ static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *
         if (is_combo_active) {
             if (ALL_COMBO_KEYS_ARE_DOWN) { /* Combo was pressed */
                 send_combo(combo->keycode, true);
-                combo->timer = COMBO_TIMER_ELAPSED;
+                cancel_deferred(&combo->timeout);
+                combo->disabled = true;
             } else { /* Combo key was pressed */
-                combo->timer = timer_read();
+                defer(&combo->timeout, COMBO_TERM, combo_timeout, combo);
 #ifdef COMBO_ALLOW_ACTION_KEYS
                 combo->prev_record = *record;
 #else
@@ -83,14 +105,14 @@ static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *
             send_keyboard_report();
             unregister_code16(keycode);
 #endif
-            combo->timer = 0;            
+            reset_combo(combo);
         }
 
         KEY_STATE_UP(index);        
     }
 
     if (NO_COMBO_KEYS_ARE_DOWN) {
-        combo->timer = 0;
+        reset_combo(combo);
     }
 
     return is_combo_active;
@@ -107,28 +129,3 @@ bool process_combo(uint16_t keycode, keyrecord_t *record)
 
     return !is_combo_key;
 }
-
-void matrix_scan_combo(void)
-{
-    for (int i = 0; i < COMBO_COUNT; ++i) {
-        combo_t *combo = &key_combos[i];
-        if (combo->timer && 
-            combo->timer != COMBO_TIMER_ELAPSED && 
-            timer_elapsed(combo->timer) > COMBO_TERM) {
-            
-            /* This disables the combo, meaning key events for this
-             * combo will be handled by the next processors in the chain 
-             */
-            combo->timer = COMBO_TIMER_ELAPSED;
-
-#ifdef COMBO_ALLOW_ACTION_KEYS
-            process_action(&combo->prev_record, 
-                store_or_get_action(combo->prev_record.event.pressed, 
-                                    combo->prev_record.event.key));
-#else
-            unregister_code16(combo->prev_key);
-            register_code16(combo->prev_key);
-#endif
-        }
-    }
-}
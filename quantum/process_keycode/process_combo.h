@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include "progmem.h"
 #include "quantum.h"
+#include "deferred.h"
 
 typedef struct
 {
@@ -16,7 +17,10 @@ typedef struct
 #else
     uint8_t state;
 #endif
-    uint16_t timer;
+    /* Set once the combo fired or timed out, the remaining key events are
+     * then handled by the next processors in the chain */
+    bool disabled;
+    deferred_t timeout;
 #ifdef COMBO_ALLOW_ACTION_KEYS
     keyrecord_t prev_record;
 #else
@@ -37,7 +41,6 @@ typedef struct
 #endif
 
 bool process_combo(uint16_t keycode, keyrecord_t *record);
-void matrix_scan_combo(void);
 void process_combo_event(uint8_t combo_index, bool pressed);
 
 #endif
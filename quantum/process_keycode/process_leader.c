@@ -6,6 +6,15 @@ void leader_start(void) {}
 __attribute__ ((weak))
 void leader_end(void) {}
 
+__attribute__ ((weak))
+void leader_sequence_user(uint8_t id) {}
+
+__attribute__ ((weak))
+const leader_seq_t *leader_sequences_get(uint16_t *count) {
+  *count = 0;
+  return NULL;
+}
+
 // Leader key stuff
 bool leading = false;
 uint16_t leader_time = 0;
@@ -13,6 +22,52 @@ uint16_t leader_time = 0;
 uint16_t leader_sequence[5] = {0, 0, 0, 0, 0};
 uint8_t leader_sequence_size = 0;
 
+// the table from LEADER_SEQUENCES(), and the part of it that matches what was typed so far
+static const leader_seq_t *sequences;
+static uint16_t sequences_count;
+static uint16_t match_low;
+static uint16_t match_high;
+static deferred_t leader_timeout;
+
+static uint16_t sequence_key(uint16_t index, uint8_t position) {
+  return pgm_read_word(&sequences[index].keys[position]);
+}
+
+// First sequence in [low, high) whose key at position is at least keycode,
+// or more than keycode with after set
+static uint16_t sequence_bound(uint16_t low, uint16_t high, uint8_t position, uint16_t keycode, bool after) {
+  while (low < high) {
+    uint16_t middle = (low + high) / 2;
+    uint16_t key = sequence_key(middle, position);
+    if (key < keycode || (after && key == keycode)) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+// Whether the first sequence left is exactly what was typed, shorter
+// sequences sort first so it's the only one that can be
+static bool sequence_complete(void) {
+  return match_low < match_high &&
+         (leader_sequence_size == 5 || sequence_key(match_low, leader_sequence_size) == 0);
+}
+
+static void end_sequence(bool matched) {
+  cancel_deferred(&leader_timeout);
+  leading = false;
+  if (matched) {
+    leader_sequence_user(pgm_read_byte(&sequences[match_low].id));
+  }
+  leader_end();
+}
+
+static void leader_timed_out(void *context) {
+  end_sequence(sequence_complete());
+}
+
 bool process_leader(uint16_t keycode, keyrecord_t *record) {
   // Leader key set-up
   if (record->event.pressed) {
@@ -26,13 +81,31 @@ bool process_leader(uint16_t keycode, keyrecord_t *record) {
       leader_sequence[2] = 0;
       leader_sequence[3] = 0;
       leader_sequence[4] = 0;
+      sequences = leader_sequences_get(&sequences_count);
+      if (sequences_count) {
+        match_low = 0;
+        match_high = sequences_count;
+        defer(&leader_timeout, LEADER_TIMEOUT, leader_timed_out, NULL);
+      }
       return false;
     }
     if (leading && timer_elapsed(leader_time) < LEADER_TIMEOUT) {
-      leader_sequence[leader_sequence_size] = keycode;
-      leader_sequence_size++;
+      if (leader_sequence_size < 5) {
+        leader_sequence[leader_sequence_size] = keycode;
+        leader_sequence_size++;
+      }
+      if (sequences_count) {
+        uint8_t position = leader_sequence_size - 1;
+        match_low = sequence_bound(match_low, match_high, position, keycode, false);
+        match_high = sequence_bound(match_low, match_high, position, keycode, true);
+        if (match_low == match_high) {
+          end_sequence(false);
+        } else if (match_high - match_low == 1 && sequence_complete()) {
+          end_sequence(true);
+        }
+      }
       return false;
     }
   }
   return true;
-}
\ No newline at end of file
+}
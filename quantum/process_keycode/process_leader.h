@@ -17,6 +17,48 @@ void leader_end(void);
 #define SEQ_FOUR_KEYS(key1, key2, key3, key4) if (leader_sequence[0] == (key1) && leader_sequence[1] == (key2) && leader_sequence[2] == (key3) && leader_sequence[3] == (key4) && leader_sequence[4] == 0)
 #define SEQ_FIVE_KEYS(key1, key2, key3, key4, key5) if (leader_sequence[0] == (key1) && leader_sequence[1] == (key2) && leader_sequence[2] == (key3) && leader_sequence[3] == (key4) && leader_sequence[4] == (key5))
 
+/* Sequence table
+ *
+ * Instead of testing leader_sequence in matrix_scan_user(), the sequences
+ * can be listed in a table, with an id each:
+ *
+ *   LEADER_SEQUENCES(
+ *     LEADER_SEQ(LEAD_COPY, KC_C),
+ *     LEADER_SEQ(LEAD_CUT, KC_C, KC_X),
+ *     LEADER_SEQ(LEAD_PASTE, KC_V),
+ *   );
+ *
+ * leader_sequence_user(id) is called with the id of the sequence typed. The
+ * table is matched on every key: as soon as a sequence is typed that no
+ * longer sequence starts with, it runs, without waiting for LEADER_TIMEOUT.
+ * A sequence that starts a longer one (C above) runs once LEADER_TIMEOUT
+ * passes, and a key that no sequence continues with ends the leader.
+ *
+ * The sequences have to be sorted by their first keycode, then their second
+ * and so on, a shorter sequence before the longer ones it starts. Each key
+ * then takes a binary search in the part of the table that matches so far.
+ */
+#define LEADER_SEQ(id, ...) { { __VA_ARGS__ }, (id) }
+#define LEADER_SEQUENCES(...) \
+  static const leader_seq_t leader_sequences[] PROGMEM = { __VA_ARGS__ }; \
+  const leader_seq_t *leader_sequences_get(uint16_t *count) { \
+    *count = sizeof(leader_sequences) / sizeof(leader_sequences[0]); \
+    return leader_sequences; \
+  } \
+  extern const leader_seq_t *leader_sequences_get(uint16_t *count)
+
+typedef struct {
+  uint16_t keys[5];
+  uint8_t id;
+} leader_seq_t;
+
+// Returns the table and its length, a keymap without LEADER_SEQUENCES()
+// gets the weak default with none. A function rather than a weak const,
+// which the compiler would fold to its default value.
+const leader_seq_t *leader_sequences_get(uint16_t *count);
+
+void leader_sequence_user(uint8_t id);
+
 #define LEADER_EXTERNS() extern bool leading; extern uint16_t leader_time; extern uint16_t leader_sequence[5]; extern uint8_t leader_sequence_size
 #define LEADER_DICTIONARY() if (leading && timer_elapsed(leader_time) > LEADER_TIMEOUT)
 
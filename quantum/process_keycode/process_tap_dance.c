@@ -4,6 +4,8 @@
 static uint16_t last_td;
 static int8_t highest_td = -1;
 
+static void tap_dance_timeout (void *context);
+
 void qk_tap_dance_pair_finished (qk_tap_dance_state_t *state, void *user_data) {
   qk_tap_dance_pair_t *pair = (qk_tap_dance_pair_t *)user_data;
 
@@ -74,6 +76,7 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
       action->state.keycode = keycode;
       action->state.count++;
       action->state.timer = timer_read();
+      defer (&action->timeout, TAPPING_TERM, tap_dance_timeout, action);
       action->state.oneshot_mods = get_oneshot_mods();
       process_tap_dance_action_on_each_tap (action);
 
@@ -85,6 +88,10 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
       }
 
       last_td = keycode;
+    } else if (action->state.finished && !is_deferred_pending (&action->timeout)) {
+      // the dance timed out while the key was held, otherwise the pending
+      // timeout resets it
+      reset_tap_dance (&action->state);
     }
 
     break;
@@ -110,17 +117,12 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
   return true;
 }
 
-void matrix_scan_tap_dance () {
-  if (highest_td == -1)
-    return;
-
-for (int i = 0; i <= highest_td; i++) {
-    qk_tap_dance_action_t *action = &tap_dance_actions[i];
+static void tap_dance_timeout (void *context) {
+  qk_tap_dance_action_t *action = (qk_tap_dance_action_t *)context;
 
-    if (action->state.count && timer_elapsed (action->state.timer) > TAPPING_TERM) {
-      process_tap_dance_action_on_dance_finished (action);
-      reset_tap_dance (&action->state);
-    }
+  if (action->state.count) {
+    process_tap_dance_action_on_dance_finished (action);
+    reset_tap_dance (&action->state);
   }
 }
 
@@ -133,6 +135,7 @@ void reset_tap_dance (qk_tap_dance_state_t *state) {
   action = &tap_dance_actions[state->keycode - QK_TAP_DANCE];
 
   process_tap_dance_action_on_reset (action);
+  cancel_deferred (&action->timeout);
 
   state->count = 0;
   state->interrupted = false;
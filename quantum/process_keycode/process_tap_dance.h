@@ -5,6 +5,7 @@
 
 #include <stdbool.h>
 #include <inttypes.h>
+#include "deferred.h"
 
 typedef struct
 {
@@ -30,6 +31,7 @@ typedef struct
   } fn;
   qk_tap_dance_state_t state;
   void *user_data;
+  deferred_t timeout;
 } qk_tap_dance_action_t;
 
 typedef struct
@@ -58,7 +60,6 @@ extern qk_tap_dance_action_t tap_dance_actions[];
 /* To be used internally */
 
 bool process_tap_dance(uint16_t keycode, keyrecord_t *record);
-void matrix_scan_tap_dance (void);
 void reset_tap_dance (qk_tap_dance_state_t *state);
 
 void qk_tap_dance_pair_finished (qk_tap_dance_state_t *state, void *user_data);
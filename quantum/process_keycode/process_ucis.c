@@ -2,45 +2,127 @@
 
 qk_ucis_state_t qk_ucis_state;
 
+#ifdef UNICODE_ASYNC
+// the fallback has to fit in the queue, or the input is typed back cut short
+typedef char qk_ucis_fallback_fits[
+    UNICODE_QUEUE_SIZE >= UCIS_MAX_SYMBOL_LENGTH + 2 ? 1 : -1];
+#endif
+
 void qk_ucis_start(void) {
   qk_ucis_state.count = 0;
   qk_ucis_state.in_progress = true;
+  qk_ucis_state.low = 0;
+  qk_ucis_state.high = ucis_symbol_table_size;
 
   qk_ucis_start_user();
 }
 
 __attribute__((weak))
 void qk_ucis_start_user(void) {
+#ifdef UNICODE_ASYNC
+  unicode_queue(0x2328);
+#else
   unicode_input_start();
   register_hex(0x2328);
   unicode_input_finish();
+#endif
 }
 
-static bool is_uni_seq(char *seq) {
-  uint8_t i;
+static char keycode_to_char(uint16_t keycode) {
+  switch (keycode) {
+    case KC_A ... KC_Z:
+      return keycode - KC_A + 'a';
+    case KC_1 ... KC_9:
+      return keycode - KC_1 + '1';
+    case KC_0:
+      return '0';
+  }
+  // matches no symbol
+  return 0xFF;
+}
 
-  for (i = 0; seq[i]; i++) {
-    uint16_t code;
-    if (('1' <= seq[i]) && (seq[i] <= '0'))
-      code = seq[i] - '1' + KC_1;
-    else
-      code = seq[i] - 'a' + KC_A;
+static uint8_t symbol_char(uint16_t index, uint8_t position) {
+  if (position >= UCIS_SYMBOL_SIZE) {
+    return 0;
+  }
+  return pgm_read_byte(&ucis_symbol_table[index].symbol[position]);
+}
 
-    if (i > qk_ucis_state.count || qk_ucis_state.codes[i] != code)
-      return false;
+// First symbol in [low, high) whose character at position is at least c,
+// or more than c with after set
+static uint16_t symbol_bound(uint16_t low, uint16_t high, uint8_t position, uint8_t c, bool after) {
+  while (low < high) {
+    uint16_t middle = (low + high) / 2;
+    uint8_t symbol_c = symbol_char(middle, position);
+    if (symbol_c < c || (after && symbol_c == c)) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
   }
+  return low;
+}
 
-  return (qk_ucis_state.codes[i] == KC_ENT ||
-          qk_ucis_state.codes[i] == KC_SPC);
+// Narrows the symbols matching the first position characters typed down to
+// the ones matching the next one as well
+static void narrow_symbols(uint8_t position) {
+  uint8_t c = keycode_to_char(qk_ucis_state.codes[position]);
+  qk_ucis_state.low = symbol_bound(qk_ucis_state.low, qk_ucis_state.high, position, c, false);
+  qk_ucis_state.high = symbol_bound(qk_ucis_state.low, qk_ucis_state.high, position, c, true);
 }
 
+static void match_symbols(void) {
+  qk_ucis_state.low = 0;
+  qk_ucis_state.high = ucis_symbol_table_size;
+  for (uint8_t i = 0; i < qk_ucis_state.count; i++) {
+    narrow_symbols(i);
+  }
+}
+
+// The symbol the length characters typed stand for: the one spelled exactly
+// like that, or the only one starting with them. Shorter symbols sort first,
+// so an exact match is the first one left.
+static int16_t typed_symbol(uint8_t length) {
+  if (qk_ucis_state.low == qk_ucis_state.high) {
+    return -1;
+  }
+  if (symbol_char(qk_ucis_state.low, length) == 0 ||
+      qk_ucis_state.high - qk_ucis_state.low == 1) {
+    return qk_ucis_state.low;
+  }
+  return -1;
+}
+
+uint16_t qk_ucis_matches(void) {
+  return qk_ucis_state.high - qk_ucis_state.low;
+}
+
+#ifndef UNICODE_ASYNC
+static void register_ucis_code(uint32_t code) {
+  // at least four digits, like register_hex()
+  int8_t i = 3;
+  while (i < 7 && (code >> ((i + 1) * 4))) {
+    i++;
+  }
+  for (; i >= 0; i--) {
+    uint8_t keycode = hex_to_keycode((code >> (i * 4)) & 0xF);
+    register_code(keycode);
+    unregister_code(keycode);
+  }
+}
+#endif
+
 __attribute__((weak))
 void qk_ucis_symbol_fallback (void) {
   for (uint8_t i = 0; i < qk_ucis_state.count - 1; i++) {
     uint8_t code = qk_ucis_state.codes[i];
+#ifdef UNICODE_ASYNC
+    unicode_queue_tap(code, 1);
+#else
     register_code(code);
     unregister_code(code);
     wait_ms(UNICODE_TYPE_DELAY);
+#endif
   }
 }
 
@@ -73,8 +155,6 @@ void register_ucis(const char *hex) {
 }
 
 bool process_ucis (uint16_t keycode, keyrecord_t *record) {
-  uint8_t i;
-
   if (!qk_ucis_state.in_progress)
     return true;
 
@@ -92,6 +172,7 @@ bool process_ucis (uint16_t keycode, keyrecord_t *record) {
   if (keycode == KC_BSPC) {
     if (qk_ucis_state.count >= 2) {
       qk_ucis_state.count -= 2;
+      match_symbols();
       return true;
     } else {
       qk_ucis_state.count--;
@@ -100,34 +181,43 @@ bool process_ucis (uint16_t keycode, keyrecord_t *record) {
   }
 
   if (keycode == KC_ENT || keycode == KC_SPC || keycode == KC_ESC) {
-    bool symbol_found = false;
-
-    for (i = qk_ucis_state.count; i > 0; i--) {
+#ifdef UNICODE_ASYNC
+    unicode_queue_tap(KC_BSPC, qk_ucis_state.count);
+#else
+    for (uint8_t i = qk_ucis_state.count; i > 0; i--) {
       register_code (KC_BSPC);
       unregister_code (KC_BSPC);
       wait_ms(UNICODE_TYPE_DELAY);
     }
+#endif
 
     if (keycode == KC_ESC) {
       qk_ucis_state.in_progress = false;
       return false;
     }
 
+#ifndef UNICODE_ASYNC
     unicode_input_start();
-    for (i = 0; ucis_symbol_table[i].symbol; i++) {
-      if (is_uni_seq (ucis_symbol_table[i].symbol)) {
-        symbol_found = true;
-        register_ucis(ucis_symbol_table[i].code + 2);
-        break;
-      }
-    }
-    if (!symbol_found) {
+#endif
+    int16_t symbol = typed_symbol(qk_ucis_state.count - 1);
+    if (symbol >= 0) {
+      uint32_t code = pgm_read_dword(&ucis_symbol_table[symbol].code);
+#ifdef UNICODE_ASYNC
+      unicode_queue(code);
+#else
+      register_ucis_code(code);
+#endif
+    } else {
       qk_ucis_symbol_fallback();
     }
+#ifndef UNICODE_ASYNC
     unicode_input_finish();
+#endif
 
     qk_ucis_state.in_progress = false;
     return false;
   }
+
+  narrow_symbols(qk_ucis_state.count - 1);
   return true;
 }
\ No newline at end of file
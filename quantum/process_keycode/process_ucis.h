@@ -8,27 +8,52 @@
 #define UCIS_MAX_SYMBOL_LENGTH 32
 #endif
 
+/* Longest symbol name, a name this long has no terminating 0 */
+#ifndef UCIS_SYMBOL_SIZE
+#define UCIS_SYMBOL_SIZE 8
+#endif
+
 typedef struct {
-  char *symbol;
-  char *code;
+  char symbol[UCIS_SYMBOL_SIZE];
+  uint32_t code;
 } qk_ucis_symbol_t;
 
 typedef struct {
   uint8_t count;
   uint16_t codes[UCIS_MAX_SYMBOL_LENGTH];
   bool in_progress:1;
+  // the symbols starting with what was typed so far
+  uint16_t low;
+  uint16_t high;
 } qk_ucis_state_t;
 
 extern qk_ucis_state_t qk_ucis_state;
 
-#define UCIS_TABLE(...) {__VA_ARGS__, {NULL, NULL}}
-#define UCIS_SYM(name, code) {name, #code}
+/* The symbol table lives in PROGMEM and has to be sorted by name:
+ *
+ *   UCIS_TABLE(
+ *     UCIS_SYM("coffee", 0x2615),
+ *     UCIS_SYM("poop", 0x1f4a9),
+ *     UCIS_SYM("tm", 0x2122)
+ *   );
+ *
+ * Every key typed narrows the symbols that can still match with a binary
+ * search. Enter or space picks the symbol spelled like the input, or the
+ * only one the input is a prefix of.
+ */
+#define UCIS_TABLE(...) \
+  const qk_ucis_symbol_t ucis_symbol_table[] PROGMEM = { __VA_ARGS__ }; \
+  const uint16_t ucis_symbol_table_size = sizeof(ucis_symbol_table) / sizeof(ucis_symbol_table[0])
+#define UCIS_SYM(name, code) {name, code}
 
 extern const qk_ucis_symbol_t ucis_symbol_table[];
+extern const uint16_t ucis_symbol_table_size;
 
 void qk_ucis_start(void);
 void qk_ucis_start_user(void);
 void qk_ucis_symbol_fallback (void);
+// How many symbols start with what was typed so far
+uint16_t qk_ucis_matches(void);
 void register_ucis(const char *hex);
 bool process_ucis (uint16_t keycode, keyrecord_t *record);
 
@@ -4,9 +4,13 @@
 bool process_unicode(uint16_t keycode, keyrecord_t *record) {
   if (keycode > QK_UNICODE && record->event.pressed) {
     uint16_t unicode = keycode & 0x7FFF;
+#ifdef UNICODE_ASYNC
+    unicode_queue(unicode);
+#else
     unicode_input_start();
     register_hex(unicode);
     unicode_input_finish();
+#endif
   }
   return true;
 }
@@ -82,4 +82,292 @@ void register_hex(uint16_t hex) {
     register_code(hex_to_keycode(digit));
     unregister_code(hex_to_keycode(digit));
   }
-}
\ No newline at end of file
+}
+#ifdef UNICODE_ASYNC
+
+// queue entries with this bit set tap a keycode, count << 8 | keycode
+#define UNICODE_TAP 0x80000000
+
+enum unicode_state {
+  UNICODE_IDLE = 0,
+  UNICODE_NEXT,
+  UNICODE_TAPS,
+  UNICODE_START,
+  UNICODE_DIGITS,
+  UNICODE_FINISH,
+};
+
+static uint32_t queue[UNICODE_QUEUE_SIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_count = 0;
+
+static uint8_t state = UNICODE_IDLE;
+static uint32_t current;
+static int8_t digit;
+static const macro_t *sequence;
+static uint8_t saved_mods;
+static deferred_t tick;
+
+static keyrecord_t key_buffer[UNICODE_KEY_BUFFER_SIZE];
+static uint8_t key_buffer_head = 0;
+static uint8_t key_buffer_count = 0;
+
+static void unicode_step(void *context);
+
+__attribute__((weak))
+const macro_t *unicode_start_sequence(uint8_t mode) {
+  switch (mode) {
+    case UC_OSX:
+      return MACRO(D(LALT), END);
+    case UC_LNX:
+      return MACRO(D(LCTL), D(LSFT), T(U), U(LSFT), U(LCTL), END);
+    case UC_WIN:
+      return MACRO(D(LALT), T(PPLS), END);
+    case UC_WINC:
+      return MACRO(T(RALT), T(U), END);
+  }
+  return MACRO_NONE;
+}
+
+__attribute__((weak))
+const macro_t *unicode_finish_sequence(uint8_t mode) {
+  switch (mode) {
+    case UC_OSX:
+    case UC_WIN:
+      return MACRO(U(LALT), END);
+    case UC_LNX:
+      return MACRO(T(SPC), END);
+  }
+  return MACRO_NONE;
+}
+
+bool is_unicode_busy(void) {
+  return state != UNICODE_IDLE || queue_count;
+}
+
+static bool queue_entries(uint32_t first, uint32_t second, uint8_t count) {
+  if (queue_count + count > UNICODE_QUEUE_SIZE) {
+    return false;
+  }
+  queue[(queue_head + queue_count++) % UNICODE_QUEUE_SIZE] = first;
+  if (count > 1) {
+    queue[(queue_head + queue_count++) % UNICODE_QUEUE_SIZE] = second;
+  }
+  if (state == UNICODE_IDLE && !is_deferred_pending(&tick)) {
+    defer(&tick, 0, unicode_step, NULL);
+  }
+  return true;
+}
+
+bool unicode_queue(uint32_t code) {
+  if (code > 0xFFFF && input_mode == UC_OSX) {
+    // UTF-16 surrogate pair, typed with one Option press
+    code -= 0x10000;
+    return queue_entries(0xD800 + (code >> 10), 0xDC00 + (code & 0x3FF), 2);
+  }
+  return queue_entries(code, 0, 1);
+}
+
+bool unicode_queue_tap(uint8_t keycode, uint8_t count) {
+  if (!count) {
+    return true;
+  }
+  return queue_entries(UNICODE_TAP | (uint16_t)count << 8 | keycode, 0, 1);
+}
+
+static uint32_t dequeue(void) {
+  uint32_t code = queue[queue_head];
+  queue_head = (queue_head + 1) % UNICODE_QUEUE_SIZE;
+  queue_count--;
+  return code;
+}
+
+// Index of the first hex digit to type, at least four digits are typed
+static int8_t first_digit(uint32_t code) {
+  int8_t i = 3;
+  while (i < 7 && (code >> ((i + 1) * 4))) {
+    i++;
+  }
+  return i;
+}
+
+// Runs one command of the current sequence, returns false once it ended
+static bool sequence_step(uint16_t *delay) {
+  if (!sequence) {
+    return false;
+  }
+  switch (MACRO_GET(sequence++)) {
+    case KEY_DOWN:
+      register_code(MACRO_GET(sequence++));
+      return true;
+    case KEY_UP:
+      unregister_code(MACRO_GET(sequence++));
+      return true;
+    case WAIT:
+      *delay = MACRO_GET(sequence++);
+      return true;
+    default:
+      sequence = NULL;
+      return false;
+  }
+}
+
+static void replay_buffered_keys(void) {
+  while (key_buffer_count && !is_unicode_busy()) {
+    keyrecord_t record = key_buffer[key_buffer_head];
+    key_buffer_head = (key_buffer_head + 1) % UNICODE_KEY_BUFFER_SIZE;
+    key_buffer_count--;
+    process_record(&record);
+  }
+}
+
+static void unicode_step(void *context) {
+  uint16_t delay = 0;
+
+  switch (state) {
+    case UNICODE_IDLE:
+      // start from a clean state, the mods come back once the queue is empty
+      saved_mods = get_mods();
+      clear_mods();
+      send_keyboard_report();
+      state = UNICODE_NEXT;
+      break;
+    case UNICODE_NEXT:
+      if (!queue_count) {
+        set_mods(saved_mods);
+        send_keyboard_report();
+        state = UNICODE_IDLE;
+        replay_buffered_keys();
+        return;
+      }
+      current = dequeue();
+      if (current & UNICODE_TAP) {
+        state = UNICODE_TAPS;
+      } else {
+        sequence = unicode_start_sequence(input_mode);
+        state = UNICODE_START;
+      }
+      break;
+    case UNICODE_TAPS: {
+      uint8_t keycode = current & 0xFF;
+      register_code(keycode);
+      unregister_code(keycode);
+      current -= 1 << 8;
+      if (!(current & 0xFF00)) {
+        state = UNICODE_NEXT;
+      }
+      delay = UNICODE_TYPE_DELAY;
+      break;
+    }
+    case UNICODE_START:
+      if (!sequence_step(&delay)) {
+        digit = first_digit(current);
+        state = UNICODE_DIGITS;
+        delay = UNICODE_TYPE_DELAY;
+      }
+      break;
+    case UNICODE_DIGITS: {
+      uint8_t keycode = hex_to_keycode((current >> (digit * 4)) & 0xF);
+      register_code(keycode);
+      unregister_code(keycode);
+      if (digit--) {
+        break;
+      }
+      if (input_mode == UC_OSX && queue_count && !(queue[queue_head] & UNICODE_TAP)) {
+        // Option is still held, go straight on with the next code point
+        current = dequeue();
+        digit = first_digit(current);
+        break;
+      }
+      sequence = unicode_finish_sequence(input_mode);
+      state = UNICODE_FINISH;
+      break;
+    }
+    case UNICODE_FINISH:
+      if (!sequence_step(&delay)) {
+        state = UNICODE_NEXT;
+      }
+      break;
+  }
+  defer(&tick, delay, unicode_step, NULL);
+}
+
+static bool is_unicode_keycode(uint16_t keycode) {
+#ifdef UNICODE_ENABLE
+  if (keycode > QK_UNICODE) {
+    return true;
+  }
+#endif
+#ifdef UNICODEMAP_ENABLE
+  if ((keycode & QK_UNICODE_MAP) == QK_UNICODE_MAP) {
+    return true;
+  }
+#endif
+  return false;
+}
+
+// The mods a key holds until it's released
+static uint8_t keycode_mods(uint16_t keycode) {
+  if (keycode >= KC_LCTRL && keycode <= KC_RGUI) {
+    return MOD_BIT(keycode);
+  }
+  if ((keycode >= QK_MODS && keycode <= QK_MODS_MAX) ||
+      (keycode >= QK_MOD_TAP && keycode <= QK_MOD_TAP_MAX)) {
+    uint8_t mods = (keycode >> 8) & 0x1F;
+    return (mods & 0x10) ? (mods & 0x0F) << 4 : mods;
+  }
+  return 0;
+}
+
+// Takes the buffered press of a released key out of the buffer, returns
+// false when the key's last buffered event isn't a press
+static bool unbuffer_press(keypos_t key) {
+  uint8_t i = key_buffer_count;
+  while (i--) {
+    keyrecord_t *buffered = &key_buffer[(key_buffer_head + i) % UNICODE_KEY_BUFFER_SIZE];
+    if (!KEYEQ(buffered->event.key, key)) {
+      continue;
+    }
+    if (!buffered->event.pressed) {
+      return false;
+    }
+    for (; i + 1 < key_buffer_count; i++) {
+      key_buffer[(key_buffer_head + i) % UNICODE_KEY_BUFFER_SIZE] =
+        key_buffer[(key_buffer_head + i + 1) % UNICODE_KEY_BUFFER_SIZE];
+    }
+    key_buffer_count--;
+    return true;
+  }
+  return false;
+}
+
+bool process_unicode_buffer(uint16_t keycode, keyrecord_t *record) {
+  if (!is_unicode_busy()) {
+    return true;
+  }
+  // a Unicode key queues its code point behind the ones being typed, as
+  // long as nothing typed before it is waiting
+  if (!key_buffer_count && is_unicode_keycode(keycode)) {
+    return true;
+  }
+  if (key_buffer_count == UNICODE_KEY_BUFFER_SIZE) {
+    if (record->event.pressed) {
+      // dropped, it would land in the middle of a hex sequence
+      return false;
+    }
+    // a release can't be dropped, it goes together with its press if that
+    // is still waiting
+    if (unbuffer_press(record->event.key)) {
+      return false;
+    }
+    // otherwise the key went down before the sequence, keep its mods from
+    // coming back with the saved ones
+    saved_mods &= ~keycode_mods(keycode);
+    return true;
+  }
+  key_buffer[(key_buffer_head + key_buffer_count) % UNICODE_KEY_BUFFER_SIZE] = *record;
+  key_buffer_count++;
+  return false;
+}
+
+#endif
@@ -16,6 +16,47 @@ void unicode_input_start(void);
 void unicode_input_finish(void);
 void register_hex(uint16_t hex);
 
+#ifdef UNICODE_ASYNC
+/* With UNICODE_ASYNC defined in config.h, the Unicode keycodes and UCIS
+ * queue their code points instead of typing them on the spot. The queue is
+ * typed one step per millisecond from the matrix scan, with the start and
+ * finish sequences of the input mode around every code point. On OS X,
+ * consecutive code points share one Option press.
+ *
+ * The keyboard keeps scanning meanwhile. Keys pressed before the queue runs
+ * dry are held back and processed afterwards, so they don't end up in the
+ * middle of a hex sequence. Only UNICODE_KEY_BUFFER_SIZE keys are held back,
+ * presses after that are dropped. A release then takes its press out of the
+ * buffer, or is processed right away when the press wasn't buffered.
+ */
+#include "action_macro.h"
+
+#ifndef UNICODE_QUEUE_SIZE
+#ifdef UCIS_ENABLE
+// the UCIS fallback queues its backspaces and every key of the input again
+#define UNICODE_QUEUE_SIZE (UCIS_MAX_SYMBOL_LENGTH + 2)
+#else
+#define UNICODE_QUEUE_SIZE 16
+#endif
+#endif
+
+#ifndef UNICODE_KEY_BUFFER_SIZE
+#define UNICODE_KEY_BUFFER_SIZE 8
+#endif
+
+// These return false if the queue is full
+bool unicode_queue(uint32_t code);
+bool unicode_queue_tap(uint8_t keycode, uint8_t count);
+bool is_unicode_busy(void);
+
+// MACRO() sequences around every code point, override these to change
+// the key that starts the input, like unicode_input_start()
+const macro_t *unicode_start_sequence(uint8_t mode);
+const macro_t *unicode_finish_sequence(uint8_t mode);
+
+bool process_unicode_buffer(uint16_t keycode, keyrecord_t *record);
+#endif
+
 #define UC_OSX 0  // Mac OS X
 #define UC_LNX 1  // Linux
 #define UC_WIN 2  // Windows 'HexNumpad'
@@ -34,6 +34,14 @@ bool process_unicode_map(uint16_t keycode, keyrecord_t *record) {
     const uint32_t* map = unicode_map;
     uint16_t index = keycode - QK_UNICODE_MAP;
     uint32_t code = pgm_read_dword_far(&map[index]);
+#ifdef UNICODE_ASYNC
+    if ((code > 0x10ffff && input_mode == UC_OSX) || (code > 0xFFFFF && input_mode == UC_LNX)) {
+      unicode_map_input_error();
+    } else {
+      // surrogate pairs are made by unicode_queue()
+      unicode_queue(code);
+    }
+#else
     if (code > 0xFFFF && code <= 0x10ffff && input_mode == UC_OSX) {
       // Convert to UTF-16 surrogate pair
       code -= 0x10000;
@@ -51,6 +59,7 @@ bool process_unicode_map(uint16_t keycode, keyrecord_t *record) {
       register_hex32(code);
       unicode_input_finish();
     }
+#endif
   }
   return true;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "quantum.h"
+#include "host.h"
 #ifdef PROTOCOL_LUFA
 #include "outputselect.h"
 #endif
@@ -102,6 +103,7 @@ void reset_keyboard(void) {
   stop_all_notes();
   shutdown_user();
 #endif
+  settings_flush();
   wait_ms(250);
 #ifdef CATERINA_BOOTLOADER
   *(uint16_t *)0x0800 = 0x7777; // these two are a-star-specific
@@ -118,6 +120,8 @@ void reset_keyboard(void) {
   #define RSPC_KEY KC_0
 #endif
 
+static setting_t keymap_setting = SETTING(EECONFIG_KEYMAP, keymap_config);
+
 static bool shift_interrupted[2] = {0, 0};
 static uint16_t scs_timer = 0;
 
@@ -152,6 +156,9 @@ bool process_record_quantum(keyrecord_t *record) {
     // }
 
   if (!(
+  #if defined(UNICODE_ASYNC) && (defined(UNICODE_ENABLE) || defined(UNICODEMAP_ENABLE) || defined(UCIS_ENABLE))
+    process_unicode_buffer(keycode, record) &&
+  #endif
     process_record_kb(keycode, record) &&
   #ifdef MIDI_ENABLE
     process_midi(keycode, record) &&
@@ -308,9 +315,9 @@ bool process_record_quantum(keyrecord_t *record) {
         // MAGIC actions (BOOTMAGIC without the boot)
         if (!eeconfig_is_enabled()) {
             eeconfig_init();
+            keymap_config.raw = eeconfig_read_keymap();
         }
-        /* keymap config */
-        keymap_config.raw = eeconfig_read_keymap();
+        /* keymap config, loaded at startup and cached since */
         switch (keycode)
         {
           case MAGIC_SWAP_CONTROL_CAPSLOCK:
@@ -375,7 +382,7 @@ bool process_record_quantum(keyrecord_t *record) {
           default:
             break;
         }
-        eeconfig_update_keymap(keymap_config.raw);
+        setting_changed(&keymap_setting);
         clear_keyboard(); // clear to prevent stuck keys
 
         return false;
@@ -538,6 +545,63 @@ void send_string(const char *str) {
     }
 }
 
+/* Types runs of characters with a single report each. A run is pressed
+ * together and released together, so it must only hold distinct keys with
+ * the same shift state. Hosts may report the keys of one report in usage
+ * order rather than report order (NKRO always does), so a run also has to
+ * be in ascending keycode order, and in 6KRO mode fit the free slots.
+ */
+void send_string_packed(const char *str) {
+    uint8_t run[KEYBOARD_REPORT_KEYS];
+    uint8_t ascii_code = pgm_read_byte(str);
+
+    while (ascii_code) {
+        uint8_t slots = KEYBOARD_REPORT_KEYS;
+#ifdef NKRO_ENABLE
+        if (!(keyboard_protocol && keymap_config.nkro))
+#endif
+        {
+            slots = 0;
+            for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+                if (!keyboard_report->keys[i]) {
+                    slots++;
+                }
+            }
+            if (!slots) {
+                slots = 1;
+            }
+        }
+
+        bool shift = pgm_read_byte(&ascii_to_qwerty_shift_lut[ascii_code]);
+        uint8_t count = 0;
+        do {
+            uint8_t keycode = pgm_read_byte(&ascii_to_qwerty_keycode_lut[ascii_code]);
+            if (count && keycode <= run[count - 1]) {
+                break;
+            }
+            run[count++] = keycode;
+            ascii_code = pgm_read_byte(++str);
+        } while (ascii_code && count < slots &&
+                 pgm_read_byte(&ascii_to_qwerty_shift_lut[ascii_code]) == shift);
+
+        if (shift) {
+            add_weak_mods(MOD_BIT(KC_LSFT));
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            add_key(run[i]);
+        }
+        send_keyboard_report();
+
+        if (shift) {
+            del_weak_mods(MOD_BIT(KC_LSFT));
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            del_key(run[i]);
+        }
+        send_keyboard_report();
+    }
+}
+
 void update_tri_layer(uint8_t layer1, uint8_t layer2, uint8_t layer3) {
   if (IS_LAYER_ON(layer1) && IS_LAYER_ON(layer2)) {
     layer_on(layer3);
@@ -588,6 +652,9 @@ void matrix_init_quantum() {
   #ifdef BACKLIGHT_ENABLE
     backlight_init_ports();
   #endif
+  #ifdef DYNAMIC_KEYMAP_ENABLE
+    dynamic_keymap_init();
+  #endif
   matrix_init_kb();
 }
 
@@ -596,13 +663,7 @@ void matrix_scan_quantum() {
     matrix_scan_music();
   #endif
 
-  #ifdef TAP_DANCE_ENABLE
-    matrix_scan_tap_dance();
-  #endif
-
-  #ifdef COMBO_ENABLE
-    matrix_scan_combo();
-  #endif
+  deferred_task();
 
   #if defined(BACKLIGHT_ENABLE) && defined(BACKLIGHT_PIN)
     backlight_task();
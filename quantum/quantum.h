@@ -25,6 +25,8 @@
 #include "action_util.h"
 #include <stdlib.h>
 #include "print.h"
+#include "deferred.h"
+#include "settings.h"
 
 
 extern uint32_t default_layer_state;
@@ -74,8 +76,21 @@ extern uint32_t default_layer_state;
 	#include "process_combo.h"
 #endif
 
+#ifdef ASYNC_MACRO_ENABLE
+	#include "async_macro.h"
+#endif
+
+#ifdef DYNAMIC_KEYMAP_ENABLE
+	#include "dynamic_keymap.h"
+#endif
+
 #define SEND_STRING(str) send_string(PSTR(str))
 void send_string(const char *str);
+#define SEND_STRING_PACKED(str) send_string_packed(PSTR(str))
+void send_string_packed(const char *str);
+
+extern const bool ascii_to_qwerty_shift_lut[0x80];
+extern const uint8_t ascii_to_qwerty_keycode_lut[0x80];
 
 // For tri-layer
 void update_tri_layer(uint8_t layer1, uint8_t layer2, uint8_t layer3);
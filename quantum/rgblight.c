@@ -5,6 +5,7 @@
 #include "timer.h"
 #include "rgblight.h"
 #include "debug.h"
+#include "settings.h"
 
 // Lightness curve using the CIE 1931 lightness formula
 //Generated by the python script provided in http://jared.geek.nz/2013/feb/linear-led-pwm
@@ -70,6 +71,7 @@ __attribute__ ((weak))
 const uint16_t RGBLED_GRADIENT_RANGES[] PROGMEM = {360, 240, 180, 120, 90};
 
 rgblight_config_t rgblight_config;
+static setting_t rgblight_setting = SETTING(EECONFIG_RGBLIGHT, rgblight_config);
 rgblight_config_t inmem_config;
 
 LED_TYPE led[RGBLED_NUM];
@@ -134,12 +136,6 @@ void setrgb(uint8_t r, uint8_t g, uint8_t b, LED_TYPE *led1) {
 }
 
 
-uint32_t eeconfig_read_rgblight(void) {
-  return eeprom_read_dword(EECONFIG_RGBLIGHT);
-}
-void eeconfig_update_rgblight(uint32_t val) {
-  eeprom_update_dword(EECONFIG_RGBLIGHT, val);
-}
 void eeconfig_update_rgblight_default(void) {
   dprintf("eeconfig_update_rgblight_default\n");
   rgblight_config.enable = 1;
@@ -187,7 +183,7 @@ void rgblight_init(void) {
 
 void rgblight_update_dword(uint32_t dword) {
   rgblight_config.raw = dword;
-  eeconfig_update_rgblight(rgblight_config.raw);
+  setting_changed(&rgblight_setting);
   if (rgblight_config.enable)
     rgblight_mode(rgblight_config.mode);
   else {
@@ -241,7 +237,7 @@ void rgblight_mode(uint8_t mode) {
   } else {
     rgblight_config.mode = mode;
   }
-  eeconfig_update_rgblight(rgblight_config.raw);
+  setting_changed(&rgblight_setting);
   xprintf("rgblight mode: %u\n", rgblight_config.mode);
   if (rgblight_config.mode == 1) {
     #ifdef RGBLIGHT_ANIMATIONS
@@ -269,7 +265,7 @@ void rgblight_mode(uint8_t mode) {
 
 void rgblight_toggle(void) {
   rgblight_config.enable ^= 1;
-  eeconfig_update_rgblight(rgblight_config.raw);
+  setting_changed(&rgblight_setting);
   xprintf("rgblight toggle: rgblight_config.enable = %u\n", rgblight_config.enable);
   if (rgblight_config.enable) {
     rgblight_mode(rgblight_config.mode);
@@ -284,7 +280,7 @@ void rgblight_toggle(void) {
 
 void rgblight_enable(void) {
   rgblight_config.enable = 1;
-  eeconfig_update_rgblight(rgblight_config.raw);
+  setting_changed(&rgblight_setting);
   xprintf("rgblight enable: rgblight_config.enable = %u\n", rgblight_config.enable);
   rgblight_mode(rgblight_config.mode);
 }
@@ -382,7 +378,7 @@ void rgblight_sethsv(uint16_t hue, uint8_t sat, uint8_t val) {
     rgblight_config.hue = hue;
     rgblight_config.sat = sat;
     rgblight_config.val = val;
-    eeconfig_update_rgblight(rgblight_config.raw);
+    setting_changed(&rgblight_setting);
     xprintf("rgblight set hsv [EEPROM]: %u,%u,%u\n", rgblight_config.hue, rgblight_config.sat, rgblight_config.val);
   }
 }
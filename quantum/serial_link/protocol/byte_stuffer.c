@@ -25,6 +25,7 @@ SOFTWARE.
 #include "serial_link/protocol/byte_stuffer.h"
 #include "serial_link/protocol/frame_validator.h"
 #include "serial_link/protocol/physical.h"
+#include "serial_link/protocol/link_stats.h"
 #include <stdbool.h>
 
 // This implements the "Consistent overhead byte stuffing protocol"
@@ -55,6 +56,7 @@ void init_byte_stuffer(void) {
 
 void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
     byte_stuffer_state_t* state = &states[link];
+    get_link_stats(link)->bytes_received++;
     // Start of a new frame
     if (state->next_zero == 0) {
         state->next_zero = data;
@@ -73,6 +75,7 @@ void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
         }
         else {
             // The frame is invalid, so reset
+            get_link_stats(link)->stuffing_errors++;
             init_byte_stuffer_state(state);
         }
     }
@@ -80,6 +83,7 @@ void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
         if (state->data_pos == MAX_FRAME_SIZE) {
             // We exceeded our maximum frame size
             // therefore there's nothing else to do than reset to a new frame
+            get_link_stats(link)->stuffing_errors++;
             state->next_zero = data;
             state->long_frame = data == 0xFF;
             state->data_pos = 0;
@@ -107,6 +111,7 @@ static void send_block(uint8_t link, uint8_t* start, uint8_t* end, uint8_t num_n
     if (end > start) {
         send_data(link, start, end-start);
     }
+    get_link_stats(link)->bytes_sent += 1 + (end - start);
 }
 
 void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size) {
@@ -138,5 +143,6 @@ void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size) {
         }
         send_block(link, start, data, num_non_zero);
         send_data(link, &zero, 1);
+        get_link_stats(link)->bytes_sent++;
     }
 }
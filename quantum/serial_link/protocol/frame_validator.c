@@ -25,6 +25,7 @@ SOFTWARE.
 #include "serial_link/protocol/frame_validator.h"
 #include "serial_link/protocol/frame_router.h"
 #include "serial_link/protocol/byte_stuffer.h"
+#include "serial_link/protocol/link_stats.h"
 #include <string.h>
 
 const uint32_t poly8_lookup[256] =
@@ -109,9 +110,12 @@ void validator_recv_frame(uint8_t link, uint8_t* data, uint16_t size) {
         memcpy(&frame_crc, data + size -4, 4);
         uint32_t expected_crc = crc32_byte(data, size - 4);
         if (frame_crc == expected_crc) {
+            get_link_stats(link)->frames_ok++;
             route_incoming_frame(link, data, size-4);
+            return;
         }
     }
+    get_link_stats(link)->frames_bad_crc++;
 }
 
 void validator_send_frame(uint8_t link, uint8_t* data, uint16_t size) {
@@ -0,0 +1,48 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Fred Sundvik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SERIAL_LINK_LINK_STATS_H
+#define SERIAL_LINK_LINK_STATS_H
+
+#include <stdint.h>
+
+// Counters describing the health of a single link
+// They are only ever incremented, and wrap around on overflow
+typedef struct {
+    uint32_t frames_ok;
+    // Frames that were correctly unstuffed, but failed the crc check, or were too short to have one
+    uint32_t frames_bad_crc;
+    // Frames that were aborted by the byte stuffer, due to unexpected zeroes or being too long
+    uint32_t stuffing_errors;
+    uint32_t overrun_errors;
+    uint32_t parity_errors;
+    uint32_t framing_errors;
+    uint32_t bytes_received;
+    uint32_t bytes_sent;
+} link_stats_t;
+
+void init_link_stats(void);
+link_stats_t* get_link_stats(uint8_t link);
+
+#endif
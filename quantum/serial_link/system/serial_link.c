@@ -28,6 +28,7 @@ SOFTWARE.
 #include "serial_link/protocol/byte_stuffer.h"
 #include "serial_link/protocol/transport.h"
 #include "serial_link/protocol/frame_router.h"
+#include "serial_link/protocol/link_stats.h"
 #include "matrix.h"
 #include <stdbool.h>
 #include "print.h"
@@ -60,6 +61,11 @@ host_driver_t serial_driver = {
 #error "Serial link thread priority not set"
 #endif
 
+// How often the master measures the round trip time and collects the health of the slaves
+#ifndef SERIAL_LINK_HEALTH_INTERVAL
+#define SERIAL_LINK_HEALTH_INTERVAL 100
+#endif
+
 static SerialConfig config = {
     .sc_speed = SERIAL_LINK_BAUD
 };
@@ -110,6 +116,19 @@ static void print_error(char* str, eventflags_t flags, SerialDriver* driver) {
 #endif
 }
 
+static void update_error_stats(uint8_t link, eventflags_t flags) {
+    link_stats_t* stats = get_link_stats(link);
+    if (flags & SD_PARITY_ERROR) {
+        stats->parity_errors++;
+    }
+    if (flags & SD_FRAMING_ERROR) {
+        stats->framing_errors++;
+    }
+    if (flags & SD_OVERRUN_ERROR) {
+        stats->overrun_errors++;
+    }
+}
+
 bool is_serial_link_master(void) {
     return is_master;
 }
@@ -140,10 +159,12 @@ static THD_FUNCTION(serialThread, arg) {
             eventmask_t mask = chEvtWaitAnyTimeout(ALL_EVENTS, MS2ST(1000));
             if (mask & EVENT_MASK(1)) {
                 flags1 = chEvtGetAndClearFlags(&sd1_listener);
+                update_error_stats(DOWN_LINK, flags1);
                 print_error("DOWNLINK", flags1, &SD1);
             }
             if (mask & EVENT_MASK(2)) {
                 flags2 = chEvtGetAndClearFlags(&sd2_listener);
+                update_error_stats(UP_LINK, flags2);
                 print_error("UPLINK", flags2, &SD2);
             }
         }
@@ -171,21 +192,40 @@ void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
 static systime_t last_update = 0;
 
 typedef struct {
-    matrix_row_t rows[MATRIX_ROWS];
+    // MATRIX_ROW_WORDS words per row, one after the other
+    matrix_row_t rows[MATRIX_ROWS * MATRIX_ROW_WORDS];
 } matrix_object_t;
 
 static matrix_object_t last_matrix = {};
 
+typedef struct {
+    serial_link_health_t health;
+    // The ping sent by the master, echoed back unmodified
+    uint32_t ping;
+} link_health_object_t;
+
+static systime_t last_ping = 0;
+static systime_t last_rate_update = 0;
+static uint32_t last_bytes_received[NUM_LINKS];
+static serial_link_health_t local_health;
+static serial_link_health_t remote_health[NUM_SLAVES];
+static bool remote_health_valid[NUM_SLAVES];
+
 SLAVE_TO_MASTER_OBJECT(keyboard_matrix, matrix_object_t);
 MASTER_TO_ALL_SLAVES_OBJECT(serial_link_connected, bool);
+MASTER_TO_ALL_SLAVES_OBJECT(link_ping, uint32_t);
+SLAVE_TO_MASTER_OBJECT(link_health, link_health_object_t);
 
 static remote_object_t* remote_objects[] = {
     REMOTE_OBJECT(serial_link_connected),
     REMOTE_OBJECT(keyboard_matrix),
+    REMOTE_OBJECT(link_ping),
+    REMOTE_OBJECT(link_health),
 };
 
 void init_serial_link(void) {
     serial_link_connected = false;
+    init_link_stats();
     init_serial_link_hal();
     add_remote_objects(remote_objects, sizeof(remote_objects)/sizeof(remote_object_t*));
     init_byte_stuffer();
@@ -198,6 +238,64 @@ void init_serial_link(void) {
 
 void matrix_set_remote(matrix_row_t* rows, uint8_t index);
 
+static void update_local_health(systime_t current_time) {
+    uint8_t i;
+    for (i=0;i<NUM_LINKS;i++) {
+        local_health.links[i] = *get_link_stats(i);
+    }
+    systime_t delta = current_time - last_rate_update;
+    if (delta >= MS2ST(1000)) {
+        last_rate_update = current_time;
+        for (i=0;i<NUM_LINKS;i++) {
+            uint32_t bytes = local_health.links[i].bytes_received;
+            local_health.bytes_per_second[i] =
+                (uint64_t)(bytes - last_bytes_received[i]) * CH_CFG_ST_FREQUENCY / delta;
+            last_bytes_received[i] = bytes;
+        }
+    }
+}
+
+static void update_link_health(systime_t current_time) {
+    update_local_health(current_time);
+    if (is_serial_link_master()) {
+        if (current_time - last_ping >= MS2ST(SERIAL_LINK_HEALTH_INTERVAL)) {
+            last_ping = current_time;
+            *begin_write_link_ping() = current_time;
+            end_write_link_ping();
+        }
+        uint8_t i;
+        for (i=0;i<NUM_SLAVES;i++) {
+            link_health_object_t* h = read_link_health(i);
+            if (h) {
+                remote_health[i] = h->health;
+                remote_health[i].round_trip_time = ST2US((systime_t)(current_time - h->ping));
+                remote_health_valid[i] = true;
+            }
+        }
+    }
+    else {
+        // Answer each ping immediately, so that the round trip time doesn't include
+        // anything else than the transfer and the polling latency
+        uint32_t* ping = read_link_ping();
+        if (ping) {
+            link_health_object_t* h = begin_write_link_health();
+            h->health = local_health;
+            h->ping = *ping;
+            end_write_link_health();
+        }
+    }
+}
+
+const serial_link_health_t* get_serial_link_health(uint8_t module) {
+    if (module == 0) {
+        return &local_health;
+    }
+    if (module > NUM_SLAVES || !remote_health_valid[module - 1]) {
+        return NULL;
+    }
+    return &remote_health[module - 1];
+}
+
 void serial_link_update(void) {
     if (read_serial_link_connected()) {
         serial_link_connected = true;
@@ -206,8 +304,11 @@ void serial_link_update(void) {
     matrix_object_t matrix;
     bool changed = false;
     for(uint8_t i=0;i<MATRIX_ROWS;i++) {
-        matrix.rows[i] = matrix_get_row(i);
-        changed |= matrix.rows[i] != last_matrix.rows[i];
+        for(uint8_t w=0;w<MATRIX_ROW_WORDS;w++) {
+            uint16_t j = i * MATRIX_ROW_WORDS + w;
+            matrix.rows[j] = matrix_get_row_word(i, w);
+            changed |= matrix.rows[j] != last_matrix.rows[j];
+        }
     }
 
     systime_t current_time = chVTGetSystemTimeX();
@@ -216,7 +317,7 @@ void serial_link_update(void) {
         last_update = current_time;
         last_matrix = matrix;
         matrix_object_t* m = begin_write_keyboard_matrix();
-        for(uint8_t i=0;i<MATRIX_ROWS;i++) {
+        for(uint16_t i=0;i<MATRIX_ROWS * MATRIX_ROW_WORDS;i++) {
             m->rows[i] = matrix.rows[i];
         }
         end_write_keyboard_matrix();
@@ -228,6 +329,8 @@ void serial_link_update(void) {
     if (m) {
         matrix_set_remote(m->rows, 0);
     }
+
+    update_link_health(current_time);
 }
 
 void signal_data_written(void) {
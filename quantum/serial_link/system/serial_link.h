@@ -26,14 +26,27 @@ SOFTWARE.
 #define SERIAL_LINK_H
 
 #include "host_driver.h"
+#include "serial_link/protocol/byte_stuffer.h"
+#include "serial_link/protocol/link_stats.h"
 #include <stdbool.h>
 
+typedef struct {
+    link_stats_t links[NUM_LINKS];
+    // Received bytes per second, measured over the last second
+    uint32_t bytes_per_second[NUM_LINKS];
+    // Round trip time from the master in microseconds, zero for the master itself
+    uint32_t round_trip_time;
+} serial_link_health_t;
+
 void init_serial_link(void);
 void init_serial_link_hal(void);
 bool is_serial_link_connected(void);
 bool is_serial_link_master(void);
 host_driver_t* get_serial_link_driver(void);
 void serial_link_update(void);
+// Only valid on the master, module 0 is the master itself and 1 the first slave
+// Returns NULL if nothing has been received from the module yet
+const serial_link_health_t* get_serial_link_health(uint8_t module);
 
 #if defined(PROTOCOL_CHIBIOS)
 #include "ch.h"
@@ -0,0 +1,252 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2016 Fred Sundvik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "gtest/gtest.h"
+#include <vector>
+#include <random>
+extern "C" {
+    #include "serial_link/protocol/byte_stuffer.h"
+    #include "serial_link/protocol/frame_router.h"
+    #include "serial_link/protocol/link_stats.h"
+}
+
+// Drives the byte stuffer, frame validator and frame router through a
+// simulated chain of modules, connected with a lossy physical layer
+class LinkStress : public testing::Test {
+public:
+    LinkStress() :
+        random(1234),
+        corrupt_probability(0.0),
+        drop_probability(0.0),
+        current_module(0),
+        num_dropped(0),
+        num_corrupted(0),
+        num_delimiters(0)
+    {
+        Instance = this;
+        init_byte_stuffer();
+        init_link_stats();
+    }
+
+    ~LinkStress() {
+        Instance = nullptr;
+    }
+
+    void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
+        auto& buffer = modules[current_module].send_buffers[link];
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        std::uniform_int_distribution<int> bit(0, 7);
+        for (uint16_t i=0;i<size;i++) {
+            uint8_t d = data[i];
+            if (dist(random) < drop_probability) {
+                num_dropped++;
+                continue;
+            }
+            if (dist(random) < corrupt_probability) {
+                d ^= 1 << bit(random);
+                num_corrupted++;
+            }
+            buffer.push_back(d);
+        }
+    }
+
+    void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size) {
+        received_frame frame;
+        frame.module = current_module;
+        frame.from = from;
+        frame.data.assign(data, data + size);
+        received.push_back(frame);
+    }
+
+    void activate_module(uint8_t num) {
+        current_module = num;
+        router_set_master(num == 0);
+    }
+
+    void send_frame(uint8_t module, uint8_t destination, const std::vector<uint8_t>& payload) {
+        activate_module(module);
+        std::vector<uint8_t> buffer(payload);
+        // Room for the router and the validator
+        buffer.resize(payload.size() + 5);
+        router_send_frame(destination, buffer.data(), payload.size());
+    }
+
+    // Delivers everything sent by a module to its neighbour, followed by a
+    // zero byte, which resynchronises the receiver just like an idle line would
+    void deliver(uint8_t from, uint8_t to) {
+        uint8_t out_link = from > to ? UP_LINK : DOWN_LINK;
+        uint8_t in_link = from > to ? DOWN_LINK : UP_LINK;
+        std::vector<uint8_t> data;
+        data.swap(modules[from].send_buffers[out_link]);
+        data.push_back(0);
+        num_delimiters++;
+        activate_module(to);
+        for (auto d : data) {
+            byte_stuffer_recv_byte(in_link, d);
+        }
+    }
+
+    // The last module in the chain has no neighbour to send to
+    uint32_t discard(uint8_t module, uint8_t link) {
+        uint32_t size = modules[module].send_buffers[link].size();
+        modules[module].send_buffers[link].clear();
+        return size;
+    }
+
+    static std::vector<uint8_t> make_payload(uint8_t source, uint16_t sequence, uint16_t size) {
+        std::vector<uint8_t> payload(size);
+        payload[0] = source;
+        payload[1] = sequence & 0xFF;
+        payload[2] = sequence >> 8;
+        for (uint16_t i=3;i<size;i++) {
+            // Include zeroes, so that the stuffing is exercised
+            payload[i] = (i + sequence) % 7 == 0 ? 0 : i * 31 + sequence;
+        }
+        return payload;
+    }
+
+    uint32_t total_errors() {
+        uint32_t errors = 0;
+        for (uint8_t i=0;i<NUM_LINKS;i++) {
+            errors += get_link_stats(i)->frames_bad_crc;
+            errors += get_link_stats(i)->stuffing_errors;
+        }
+        return errors;
+    }
+
+    uint32_t total_bytes_sent() {
+        return get_link_stats(UP_LINK)->bytes_sent + get_link_stats(DOWN_LINK)->bytes_sent;
+    }
+
+    uint32_t total_bytes_received() {
+        return get_link_stats(UP_LINK)->bytes_received + get_link_stats(DOWN_LINK)->bytes_received;
+    }
+
+    struct module_buffers {
+        std::vector<uint8_t> send_buffers[NUM_LINKS];
+    };
+
+    struct received_frame {
+        uint8_t module;
+        uint8_t from;
+        std::vector<uint8_t> data;
+    };
+
+    static const uint8_t num_modules = 4;
+
+    std::mt19937 random;
+    double corrupt_probability;
+    double drop_probability;
+    module_buffers modules[num_modules];
+    uint8_t current_module;
+    std::vector<received_frame> received;
+    uint32_t num_dropped;
+    uint32_t num_corrupted;
+    uint32_t num_delimiters;
+
+    static LinkStress* Instance;
+};
+
+LinkStress* LinkStress::Instance = nullptr;
+
+extern "C" {
+    void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
+        LinkStress::Instance->send_data(link, data, size);
+    }
+
+    void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size) {
+        LinkStress::Instance->transport_recv_frame(from, data, size);
+    }
+}
+
+TEST_F(LinkStress, clean_link_delivers_and_counts_every_frame) {
+    const uint16_t num_frames = 200;
+    for (uint16_t seq=0;seq<num_frames;seq++) {
+        for (uint8_t slave=num_modules-1;slave>0;slave--) {
+            send_frame(slave, 0, make_payload(slave, seq, 3 + seq % 40));
+        }
+        for (uint8_t from=num_modules-1;from>0;from--) {
+            deliver(from, from - 1);
+        }
+    }
+    ASSERT_EQ(received.size(), num_frames * (num_modules - 1));
+    for (auto& frame : received) {
+        EXPECT_EQ(frame.module, 0);
+        uint16_t seq = frame.data[1] | (frame.data[2] << 8);
+        EXPECT_EQ(frame.from, frame.data[0]);
+        EXPECT_EQ(frame.data, make_payload(frame.data[0], seq, frame.data.size()));
+    }
+    // Slave n's frames are received n times on the way to the master
+    EXPECT_EQ(get_link_stats(DOWN_LINK)->frames_ok, num_frames * (1 + 2 + 3));
+    EXPECT_EQ(get_link_stats(UP_LINK)->frames_ok, 0);
+    EXPECT_EQ(total_errors(), 0);
+    EXPECT_EQ(total_bytes_received(), total_bytes_sent() + num_delimiters);
+}
+
+TEST_F(LinkStress, clean_broadcast_reaches_every_slave) {
+    const uint16_t num_frames = 200;
+    uint32_t discarded = 0;
+    for (uint16_t seq=0;seq<num_frames;seq++) {
+        send_frame(0, 0xFF, make_payload(0, seq, 3 + seq % 300));
+        for (uint8_t from=0;from<num_modules-1;from++) {
+            deliver(from, from + 1);
+        }
+        discarded += discard(num_modules - 1, DOWN_LINK);
+    }
+    ASSERT_EQ(received.size(), num_frames * (num_modules - 1));
+    for (auto& frame : received) {
+        uint16_t seq = frame.data[1] | (frame.data[2] << 8);
+        EXPECT_EQ(frame.data, make_payload(0, seq, frame.data.size()));
+    }
+    EXPECT_EQ(get_link_stats(UP_LINK)->frames_ok, num_frames * (num_modules - 1));
+    EXPECT_EQ(total_errors(), 0);
+    EXPECT_EQ(total_bytes_received() + discarded, total_bytes_sent() + num_delimiters);
+}
+
+TEST_F(LinkStress, lossy_link_never_delivers_corrupted_frames) {
+    corrupt_probability = 0.0005;
+    drop_probability = 0.0002;
+    const uint16_t num_frames = 2000;
+    for (uint16_t seq=0;seq<num_frames;seq++) {
+        for (uint8_t slave=num_modules-1;slave>0;slave--) {
+            send_frame(slave, 0, make_payload(slave, seq, 3 + seq % 300));
+        }
+        for (uint8_t from=num_modules-1;from>0;from--) {
+            deliver(from, from - 1);
+        }
+    }
+    EXPECT_GT(num_corrupted, 0);
+    EXPECT_GT(num_dropped, 0);
+    EXPECT_LT(received.size(), num_frames * (num_modules - 1));
+    EXPECT_GT(received.size(), num_frames * (num_modules - 1) / 2);
+    for (auto& frame : received) {
+        EXPECT_EQ(frame.module, 0);
+        uint16_t seq = frame.data[1] | (frame.data[2] << 8);
+        EXPECT_EQ(frame.from, frame.data[0]);
+        EXPECT_EQ(frame.data, make_payload(frame.data[0], seq, frame.data.size()));
+    }
+    EXPECT_GT(get_link_stats(DOWN_LINK)->frames_bad_crc, 0);
+    EXPECT_GT(get_link_stats(DOWN_LINK)->stuffing_errors, 0);
+    EXPECT_EQ(total_bytes_received() + num_dropped, total_bytes_sent() + num_delimiters);
+}
@@ -0,0 +1,31 @@
+#include "settings.h"
+#include "deferred.h"
+#include "eeconfig.h"
+#include <stddef.h>
+
+static setting_t *dirty_settings = NULL;
+static deferred_t commit;
+
+static void commit_settings(void *context) {
+  while (dirty_settings) {
+    setting_t *setting = dirty_settings;
+    dirty_settings = setting->next;
+    setting->dirty = false;
+    eeconfig_update_block(setting->ram, setting->eeprom, setting->size);
+  }
+}
+
+void setting_changed(setting_t *setting) {
+  if (!setting->dirty) {
+    setting->dirty = true;
+    setting->next = dirty_settings;
+    dirty_settings = setting;
+  }
+  // restarting the timer on every change waits for the key to be let go
+  defer(&commit, SETTINGS_COMMIT_DELAY, commit_settings, NULL);
+}
+
+void settings_flush(void) {
+  cancel_deferred(&commit);
+  commit_settings(NULL);
+}
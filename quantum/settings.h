@@ -0,0 +1,42 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Settings cache
+ *
+ * Settings that change on a keypress, like the RGB light hue or the magic
+ * keycode swaps, live in RAM and are written to EEPROM once no setting has
+ * changed for SETTINGS_COMMIT_DELAY ms. Holding a key that adjusts them
+ * then costs one EEPROM write instead of one per step, and the scan loop
+ * never waits for the EEPROM in between. Only the bytes that changed are
+ * written, through eeconfig_update_block().
+ *
+ * A setting is declared next to the variable it caches:
+ *
+ *   static setting_t rgblight_setting = SETTING(EECONFIG_RGBLIGHT, rgblight_config);
+ *
+ * and setting_changed(&rgblight_setting) is called after the variable is
+ * modified.
+ */
+
+#ifndef SETTINGS_COMMIT_DELAY
+  #define SETTINGS_COMMIT_DELAY 3000
+#endif
+
+typedef struct setting {
+  void *eeprom;
+  const void *ram;
+  uint8_t size;
+  bool dirty;
+  struct setting *next;
+} setting_t;
+
+#define SETTING(eeprom_address, variable) { (void *)(eeprom_address), &(variable), sizeof(variable), false, NULL }
+
+void setting_changed(setting_t *setting);
+// Writes everything pending right away, before jumping to the bootloader
+void settings_flush(void);
+
+#endif
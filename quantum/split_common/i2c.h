@@ -13,7 +13,9 @@
 #define I2C_ACK 1
 #define I2C_NACK 0
 
-#define SLAVE_BUFFER_SIZE 0x10
+#ifndef SLAVE_BUFFER_SIZE
+#define SLAVE_BUFFER_SIZE 0x20
+#endif
 
 // i2c SCL clock frequency
 #define SCL_CLOCK  100000L
@@ -12,7 +12,7 @@
 #include <stdbool.h>
 #include "serial.h"
 
-#ifdef USE_SERIAL
+#if defined(USE_SERIAL) && !defined(USE_SERIAL_USART)
 
 // Serial pulse period in microseconds. Its probably a bad idea to lower this
 // value.
@@ -2,6 +2,7 @@
 #define MY_SERIAL_H
 
 #include "config.h"
+#include "transport.h"
 #include <stdbool.h>
 
 /* TODO:  some defines for interrupt setup */
@@ -11,8 +12,17 @@
 #define SERIAL_PIN_MASK _BV(PD0)
 #define SERIAL_PIN_INTERRUPT INT0_vect
 
-#define SERIAL_SLAVE_BUFFER_LENGTH MATRIX_ROWS/2
-#define SERIAL_MASTER_BUFFER_LENGTH 1
+#define SERIAL_SLAVE_BUFFER_LENGTH (ROWS_PER_HAND * sizeof(matrix_row_t))
+#define SERIAL_MASTER_BUFFER_LENGTH (sizeof(split_master_state_t))
+
+/* USART transport, see serial_usart.c */
+#ifndef SERIAL_USART_SPEED
+#define SERIAL_USART_SPEED 500000
+#endif
+// Time in milliseconds after which the master gives up waiting for an answer
+#ifndef SERIAL_USART_TIMEOUT
+#define SERIAL_USART_TIMEOUT 5
+#endif
 
 // Buffers for master - slave communication
 extern volatile uint8_t serial_slave_buffer[SERIAL_SLAVE_BUFFER_LENGTH];
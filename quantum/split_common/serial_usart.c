@@ -0,0 +1,193 @@
+/*
+ * Interrupt driven split transport on the hardware USART
+ *
+ * TX (D3) of each half is connected to RX (D2) of the other half. The master
+ * starts a transaction by sending its buffer, the slave answers from its
+ * receive interrupt with the slave buffer. Everything is done by the USART
+ * interrupts, so neither half ever waits for the other one.
+ *
+ * Both directions use the same frame format: a sync byte, the data and a
+ * checksum of the data.
+ */
+
+#ifndef F_CPU
+#define F_CPU 16000000
+#endif
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdbool.h>
+#include "serial.h"
+#include "timer.h"
+
+#ifdef USE_SERIAL_USART
+
+#if defined(RGBLIGHT_ENABLE) && defined(RGB_DI_PIN) && RGB_DI_PIN == D3
+#error "The USART transport needs D3 for TX, move RGB_DI_PIN to another pin"
+#endif
+
+#define SERIAL_USART_SYNC 0x7E
+#define SERIAL_USART_UBRR ((F_CPU / (8UL * SERIAL_USART_SPEED)) - 1)
+
+#define SERIAL_USART_BUFFER_LENGTH \
+  ((SERIAL_SLAVE_BUFFER_LENGTH) > (SERIAL_MASTER_BUFFER_LENGTH) ? \
+   (SERIAL_SLAVE_BUFFER_LENGTH) : (SERIAL_MASTER_BUFFER_LENGTH))
+
+#define RX_IDLE 0xFF
+
+uint8_t volatile serial_slave_buffer[SERIAL_SLAVE_BUFFER_LENGTH] = {0};
+uint8_t volatile serial_master_buffer[SERIAL_MASTER_BUFFER_LENGTH] = {0};
+
+#define SLAVE_DATA_CORRUPT (1<<0)
+static volatile uint8_t status = 0;
+
+enum transaction_state {
+  TRANSACTION_IDLE,
+  TRANSACTION_PENDING,
+  TRANSACTION_DONE,
+  TRANSACTION_ERROR,
+};
+
+static volatile uint8_t transaction_state = TRANSACTION_IDLE;
+static uint16_t transaction_start = 0;
+static bool is_master = false;
+
+// The buffer we send from and the one we receive into, depending on the role
+static volatile uint8_t *tx_source;
+static uint8_t tx_length;
+static volatile uint8_t *rx_target;
+static uint8_t rx_length;
+
+static uint8_t tx_frame[SERIAL_USART_BUFFER_LENGTH + 2];
+static volatile uint8_t tx_pos = 0;
+static volatile uint8_t tx_end = 0;
+
+static uint8_t rx_frame[SERIAL_USART_BUFFER_LENGTH];
+static volatile uint8_t rx_pos = RX_IDLE;
+static uint8_t rx_checksum = 0;
+
+static void usart_init(void) {
+  UBRR1H = (uint8_t)(SERIAL_USART_UBRR >> 8);
+  UBRR1L = (uint8_t)SERIAL_USART_UBRR;
+  UCSR1A = _BV(U2X1);
+  // 8 data bits, no parity, 1 stop bit
+  UCSR1C = _BV(UCSZ11) | _BV(UCSZ10);
+  UCSR1B = _BV(RXEN1) | _BV(TXEN1) | _BV(RXCIE1);
+  // keep RX idle when the other half is disconnected
+  PORTD |= _BV(PD2);
+}
+
+// Must be called with interrupts disabled
+static void start_transmit(void) {
+  uint8_t checksum = 0;
+  tx_frame[0] = SERIAL_USART_SYNC;
+  for (uint8_t i = 0; i < tx_length; ++i) {
+    tx_frame[i + 1] = tx_source[i];
+    checksum += tx_source[i];
+  }
+  tx_frame[tx_length + 1] = checksum;
+  tx_pos = 0;
+  tx_end = tx_length + 2;
+  UCSR1B |= _BV(UDRIE1);
+}
+
+void serial_master_init(void) {
+  is_master = true;
+  tx_source = serial_master_buffer;
+  tx_length = SERIAL_MASTER_BUFFER_LENGTH;
+  rx_target = serial_slave_buffer;
+  rx_length = SERIAL_SLAVE_BUFFER_LENGTH;
+  usart_init();
+}
+
+void serial_slave_init(void) {
+  is_master = false;
+  tx_source = serial_slave_buffer;
+  tx_length = SERIAL_SLAVE_BUFFER_LENGTH;
+  rx_target = serial_master_buffer;
+  rx_length = SERIAL_MASTER_BUFFER_LENGTH;
+  usart_init();
+}
+
+ISR(USART1_UDRE_vect) {
+  UDR1 = tx_frame[tx_pos++];
+  if (tx_pos == tx_end) {
+    UCSR1B &= ~_BV(UDRIE1);
+  }
+}
+
+static void frame_received(bool valid) {
+  if (valid) {
+    for (uint8_t i = 0; i < rx_length; ++i) {
+      rx_target[i] = rx_frame[i];
+    }
+    status &= ~SLAVE_DATA_CORRUPT;
+  } else {
+    status |= SLAVE_DATA_CORRUPT;
+  }
+
+  if (is_master) {
+    transaction_state = valid ? TRANSACTION_DONE : TRANSACTION_ERROR;
+  } else if (valid) {
+    // answer straight away, the master is waiting for us
+    start_transmit();
+  }
+}
+
+ISR(USART1_RX_vect) {
+  // the error flags have to be read before the data
+  uint8_t flags = UCSR1A;
+  uint8_t data = UDR1;
+
+  if (flags & (_BV(FE1) | _BV(DOR1) | _BV(UPE1))) {
+    if (rx_pos != RX_IDLE) {
+      rx_pos = RX_IDLE;
+      frame_received(false);
+    }
+    return;
+  }
+
+  if (rx_pos == RX_IDLE) {
+    if (data == SERIAL_USART_SYNC) {
+      rx_pos = 0;
+      rx_checksum = 0;
+    }
+  } else if (rx_pos < rx_length) {
+    rx_frame[rx_pos++] = data;
+    rx_checksum += data;
+  } else {
+    rx_pos = RX_IDLE;
+    frame_received(data == rx_checksum);
+  }
+}
+
+bool serial_slave_data_corrupt(void) {
+  return status & SLAVE_DATA_CORRUPT;
+}
+
+// Starts a new transaction, and returns the result of the previous one. The
+// slave data is updated in the background, whenever an answer arrives.
+//
+// Returns:
+// 0 => no error
+// 1 => slave did not respond, or the answer was corrupt
+int serial_update_buffers(void) {
+  uint8_t state = transaction_state;
+
+  if (state == TRANSACTION_PENDING &&
+      timer_elapsed(transaction_start) < SERIAL_USART_TIMEOUT) {
+    // still waiting for the answer, keep the data from the last transaction
+    return 0;
+  }
+
+  cli();
+  rx_pos = RX_IDLE;
+  transaction_state = TRANSACTION_PENDING;
+  start_transmit();
+  sei();
+  transaction_start = timer_read();
+
+  return (state == TRANSACTION_PENDING || state == TRANSACTION_ERROR) ? 1 : 0;
+}
+
+#endif
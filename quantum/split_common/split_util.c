@@ -7,19 +7,20 @@
 #include "split_util.h"
 #include "matrix.h"
 #include "keyboard.h"
+#include "timer.h"
 #include "config.h"
+#include "transport.h"
+#include "eeconfig.h"
 
-#ifdef USE_I2C
-#  include "i2c.h"
-#else
-#  include "serial.h"
+#ifdef RGBLIGHT_ENABLE
+#  include "rgblight.h"
 #endif
 
 volatile bool isLeftHand = true;
 
 static void setup_handedness(void) {
   #ifdef EE_HANDS
-    isLeftHand = eeprom_read_byte(EECONFIG_HANDEDNESS);
+    isLeftHand = eeconfig_read_handedness();
   #else
     // I2C_MASTER_RIGHT is deprecated use MASTER_RIGHT instead since this works for both serial and i2c
     #if defined(I2C_MASTER_RIGHT) || defined(MASTER_RIGHT)
@@ -31,19 +32,11 @@ static void setup_handedness(void) {
 }
 
 static void keyboard_master_setup(void) {
-#ifdef USE_I2C
-    i2c_master_init();
-#else
-    serial_master_init();
-#endif
+    transport_master_init();
 }
 
 static void keyboard_slave_setup(void) {
-#ifdef USE_I2C
-    i2c_slave_init(SLAVE_I2C_ADDRESS);
-#else
-    serial_slave_init();
-#endif
+    transport_slave_init();
 }
 
 bool has_usb(void) {
@@ -64,10 +57,18 @@ void split_keyboard_setup(void) {
 }
 
 void keyboard_slave_loop(void) {
+   // keyboard_init() never runs on the slave
+   timer_init();
    matrix_init();
+#ifdef RGBLIGHT_ENABLE
+   rgblight_init();
+#endif
 
    while (1) {
       matrix_slave_scan();
+#if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_ANIMATIONS)
+      rgblight_task();
+#endif
    }
 }
 
@@ -3,11 +3,6 @@
 
 #include <stdbool.h>
 
-#ifdef EE_HANDS
-	#define EECONFIG_BOOTMAGIC_END      (uint8_t *)10
-	#define EECONFIG_HANDEDNESS         EECONFIG_BOOTMAGIC_END
-#endif
-
 #define SLAVE_I2C_ADDRESS           0x32
 
 extern volatile bool isLeftHand;
@@ -15,6 +10,11 @@ extern volatile bool isLeftHand;
 // slave version of matix scan, defined in matrix.c
 void matrix_slave_scan(void);
 
+// Called on the master after every transaction with the slave, to show the
+// state of the connection
+void split_link_status_kb(bool connected);
+void split_link_status_user(bool connected);
+
 void split_keyboard_setup(void);
 bool has_usb(void);
 void keyboard_slave_loop(void);
@@ -0,0 +1,209 @@
+#include <string.h>
+#include <avr/interrupt.h>
+#include "transport.h"
+#include "split_util.h"
+#include "host.h"
+#include "led.h"
+#include "action_layer.h"
+
+#ifdef RGBLIGHT_ENABLE
+#  include "rgblight.h"
+extern rgblight_config_t rgblight_config;
+#endif
+
+#ifdef USE_I2C
+#  include "i2c.h"
+#else // USE_SERIAL
+#  include "serial.h"
+#endif
+
+#define SLAVE_MATRIX_SIZE (ROWS_PER_HAND * sizeof(matrix_row_t))
+
+__attribute__ ((weak))
+void split_master_state_kb(split_master_state_t *state) {
+  split_master_state_user(state);
+}
+
+__attribute__ ((weak))
+void split_master_state_user(split_master_state_t *state) {
+}
+
+__attribute__ ((weak))
+void split_slave_state_kb(const split_master_state_t *state) {
+  split_slave_state_user(state);
+}
+
+__attribute__ ((weak))
+void split_slave_state_user(const split_master_state_t *state) {
+}
+
+static void get_master_state(split_master_state_t *state) {
+  memset(state, 0, sizeof(split_master_state_t));
+#if defined(SPLIT_LAYER_STATE_ENABLE) && !defined(NO_ACTION_LAYER)
+  state->layer_state = layer_state;
+#endif
+#ifdef SPLIT_LED_STATE_ENABLE
+  state->led_state = host_keyboard_leds();
+#endif
+#if defined(SPLIT_RGBLIGHT_ENABLE) && defined(RGBLIGHT_ENABLE)
+  state->rgblight = rgblight_config.raw;
+#endif
+  split_master_state_kb(state);
+}
+
+static split_master_state_t slave_state;
+
+static void apply_master_state(const split_master_state_t *state) {
+  if (memcmp(state, &slave_state, sizeof(split_master_state_t)) == 0) {
+    return;
+  }
+#if defined(SPLIT_LAYER_STATE_ENABLE) && !defined(NO_ACTION_LAYER)
+  layer_state = state->layer_state;
+#endif
+#ifdef SPLIT_LED_STATE_ENABLE
+  if (state->led_state != slave_state.led_state) {
+    led_set(state->led_state);
+  }
+#endif
+#if defined(SPLIT_RGBLIGHT_ENABLE) && defined(RGBLIGHT_ENABLE)
+  if (state->rgblight != slave_state.rgblight) {
+    rgblight_update_dword(state->rgblight);
+  }
+#endif
+  slave_state = *state;
+  split_slave_state_kb(state);
+}
+
+#ifdef USE_I2C
+
+// Registers exposed by the slave
+#define I2C_MATRIX_START 0x00
+#define I2C_MASTER_STATE_START SLAVE_MATRIX_SIZE
+
+_Static_assert(I2C_MASTER_STATE_START + sizeof(split_master_state_t) <= SLAVE_BUFFER_SIZE,
+  "The split state doesn't fit into the i2c slave buffer, increase SLAVE_BUFFER_SIZE");
+
+static split_master_state_t sent_state;
+static bool sent_state_valid = false;
+
+void transport_master_init(void) {
+  i2c_master_init();
+}
+
+void transport_slave_init(void) {
+  i2c_slave_init(SLAVE_I2C_ADDRESS);
+}
+
+bool transport_master(matrix_row_t slave_matrix[]) {
+  uint8_t *rows = (uint8_t*)slave_matrix;
+
+  int err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_WRITE);
+  if (err) goto i2c_error;
+
+  err = i2c_master_write(I2C_MATRIX_START);
+  if (err) goto i2c_error;
+
+  // Start read
+  err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_READ);
+  if (err) goto i2c_error;
+
+  uint8_t i;
+  for (i = 0; i < SLAVE_MATRIX_SIZE-1; ++i) {
+    rows[i] = i2c_master_read(I2C_ACK);
+  }
+  rows[i] = i2c_master_read(I2C_NACK);
+  i2c_master_stop();
+
+  // The state is only written when it changes, or the slave has been away
+  split_master_state_t state;
+  get_master_state(&state);
+  if (!sent_state_valid || memcmp(&state, &sent_state, sizeof(split_master_state_t)) != 0) {
+    err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_WRITE);
+    if (err) goto i2c_error;
+
+    err = i2c_master_write(I2C_MASTER_STATE_START);
+    if (err) goto i2c_error;
+
+    const uint8_t *data = (const uint8_t*)&state;
+    for (i = 0; i < sizeof(split_master_state_t); ++i) {
+      err = i2c_master_write(data[i]);
+      if (err) goto i2c_error;
+    }
+    i2c_master_stop();
+    sent_state = state;
+    sent_state_valid = true;
+  }
+  return true;
+
+i2c_error: // the cable is disconnceted, or something else went wrong
+  i2c_reset_state();
+  sent_state_valid = false;
+  return false;
+}
+
+void transport_slave(const matrix_row_t slave_matrix[]) {
+  const uint8_t *rows = (const uint8_t*)slave_matrix;
+  split_master_state_t state;
+  uint8_t *data = (uint8_t*)&state;
+
+  // i2c_slave_buffer is accessed from the TWI interrupt
+  cli();
+  for (uint8_t i = 0; i < SLAVE_MATRIX_SIZE; ++i) {
+    i2c_slave_buffer[I2C_MATRIX_START + i] = rows[i];
+  }
+  for (uint8_t i = 0; i < sizeof(split_master_state_t); ++i) {
+    data[i] = i2c_slave_buffer[I2C_MASTER_STATE_START + i];
+  }
+  sei();
+
+  apply_master_state(&state);
+}
+
+#else // USE_SERIAL
+
+void transport_master_init(void) {
+  serial_master_init();
+}
+
+void transport_slave_init(void) {
+  serial_slave_init();
+}
+
+bool transport_master(matrix_row_t slave_matrix[]) {
+  split_master_state_t state;
+  get_master_state(&state);
+  const uint8_t *data = (const uint8_t*)&state;
+  for (uint8_t i = 0; i < SERIAL_MASTER_BUFFER_LENGTH; ++i) {
+    serial_master_buffer[i] = data[i];
+  }
+
+  if (serial_update_buffers()) {
+    return false;
+  }
+
+  uint8_t *rows = (uint8_t*)slave_matrix;
+  for (uint8_t i = 0; i < SERIAL_SLAVE_BUFFER_LENGTH; ++i) {
+    rows[i] = serial_slave_buffer[i];
+  }
+  return true;
+}
+
+void transport_slave(const matrix_row_t slave_matrix[]) {
+  const uint8_t *rows = (const uint8_t*)slave_matrix;
+  split_master_state_t state;
+  uint8_t *data = (uint8_t*)&state;
+
+  // the buffers are accessed from the serial interrupts
+  cli();
+  for (uint8_t i = 0; i < SERIAL_SLAVE_BUFFER_LENGTH; ++i) {
+    serial_slave_buffer[i] = rows[i];
+  }
+  for (uint8_t i = 0; i < SERIAL_MASTER_BUFFER_LENGTH; ++i) {
+    data[i] = serial_master_buffer[i];
+  }
+  sei();
+
+  apply_master_state(&state);
+}
+
+#endif
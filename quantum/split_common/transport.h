@@ -0,0 +1,50 @@
+#ifndef SPLIT_TRANSPORT_H
+#define SPLIT_TRANSPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "matrix.h"
+
+#define ROWS_PER_HAND (MATRIX_ROWS/2)
+
+// State sent by the master half to the slave half. Everything is opt-in,
+// since each byte makes the transactions longer.
+typedef struct {
+#if defined(SPLIT_LAYER_STATE_ENABLE) && !defined(NO_ACTION_LAYER)
+  uint32_t layer_state;
+#endif
+#ifdef SPLIT_LED_STATE_ENABLE
+  uint8_t led_state;
+#endif
+#if defined(SPLIT_RGBLIGHT_ENABLE) && defined(RGBLIGHT_ENABLE)
+  uint32_t rgblight;
+#endif
+#ifdef SPLIT_USER_DATA_SIZE
+  uint8_t user_data[SPLIT_USER_DATA_SIZE];
+#endif
+  // keeps the state from being empty
+  uint8_t reserved;
+} split_master_state_t;
+
+void transport_master_init(void);
+void transport_slave_init(void);
+
+// Sends the state to the slave, and reads the rows of the other half into
+// slave_matrix.
+// returns: true  => success
+//          false => the slave didn't respond
+bool transport_master(matrix_row_t slave_matrix[]);
+
+// Publishes the rows of this half, and applies the state from the master
+void transport_slave(const matrix_row_t slave_matrix[]);
+
+// Called on the master before the state is sent, to fill in user_data
+void split_master_state_kb(split_master_state_t *state);
+void split_master_state_user(split_master_state_t *state);
+
+// Called on the slave whenever the state from the master changes
+void split_slave_state_kb(const split_master_state_t *state);
+void split_slave_state_user(const split_master_state_t *state);
+
+#endif
@@ -59,6 +59,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 /* define if matrix has ghost (lacks anti-ghosting diodes) */
 //#define MATRIX_HAS_GHOST
+/* what to do with a ghosted row, see tmk_core/common/matrix.h */
+//#define MATRIX_GHOST_POLICY MATRIX_GHOST_BLOCK_KEY
 
 /* number of backlight levels */
 
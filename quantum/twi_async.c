@@ -0,0 +1,114 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/twi.h>
+#include <stddef.h>
+#include "twi_async.h"
+
+#define TWCR_ACTIVE ((1<<TWINT) | (1<<TWEN) | (1<<TWIE))
+
+static twi_transaction_t *queue_head;
+static twi_transaction_t *queue_tail;
+static volatile bool active;
+static uint8_t position;
+static bool reading;
+
+bool twi_queue(twi_transaction_t *transaction) {
+    if (transaction->status == TWI_PENDING) {
+        return false;
+    }
+    transaction->status = TWI_PENDING;
+    transaction->next = NULL;
+
+    uint8_t sreg = SREG;
+    cli();
+    if (queue_head) {
+        queue_tail->next = transaction;
+    } else {
+        queue_head = transaction;
+    }
+    queue_tail = transaction;
+    // active stays set while the last transaction's callback runs, the
+    // interrupt then starts whatever the callback queued
+    if (!active) {
+        active = true;
+        TWCR = TWCR_ACTIVE | (1<<TWSTA);
+    }
+    SREG = sreg;
+    return true;
+}
+
+uint8_t twi_wait(twi_transaction_t *transaction) {
+    while (transaction->status == TWI_PENDING) {}
+    return transaction->status;
+}
+
+bool twi_busy(void) {
+    return active;
+}
+
+void twi_wait_idle(void) {
+    while (active) {}
+    // the stop condition is still being sent after the last transaction
+    while (TWCR & (1<<TWSTO)) {}
+}
+
+static void finish(uint8_t status) {
+    twi_transaction_t *transaction = queue_head;
+    queue_head = transaction->next;
+    transaction->status = status;
+    if (transaction->callback) {
+        transaction->callback(transaction);
+    }
+    if (queue_head) {
+        // stop and start again straight away for the next transaction
+        TWCR = TWCR_ACTIVE | (1<<TWSTO) | (1<<TWSTA);
+    } else {
+        active = false;
+        TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWSTO);
+    }
+}
+
+ISR(TWI_vect) {
+    twi_transaction_t *transaction = queue_head;
+    switch (TW_STATUS) {
+        case TW_START:
+            reading = transaction->tx_length == 0 && transaction->rx_length;
+            // fall through
+        case TW_REP_START:
+            position = 0;
+            TWDR = (transaction->address << 1) | (reading ? TW_READ : TW_WRITE);
+            TWCR = TWCR_ACTIVE;
+            break;
+        case TW_MT_SLA_ACK:
+        case TW_MT_DATA_ACK:
+            if (position < transaction->tx_length) {
+                TWDR = transaction->tx[position++];
+                TWCR = TWCR_ACTIVE;
+            } else if (transaction->rx_length) {
+                reading = true;
+                TWCR = TWCR_ACTIVE | (1<<TWSTA);
+            } else {
+                finish(TWI_OK);
+            }
+            break;
+        case TW_MR_DATA_ACK:
+            transaction->rx[position++] = TWDR;
+            // fall through
+        case TW_MR_SLA_ACK:
+            // acknowledge every byte but the last one
+            if (position + 1 < transaction->rx_length) {
+                TWCR = TWCR_ACTIVE | (1<<TWEA);
+            } else {
+                TWCR = TWCR_ACTIVE;
+            }
+            break;
+        case TW_MR_DATA_NACK:
+            transaction->rx[position++] = TWDR;
+            finish(TWI_OK);
+            break;
+        default:
+            // no acknowledge from the slave, lost arbitration or a bus error
+            finish(TWI_ERROR);
+            break;
+    }
+}
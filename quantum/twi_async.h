@@ -0,0 +1,51 @@
+/* Interrupt driven TWI (I2C) master with a transaction queue
+ *
+ * Transactions are queued with twi_queue() and run back to back from the
+ * TWI interrupt, so the matrix scan can keep working while the bus is busy.
+ * Each transaction writes tx_length bytes and then, if rx_length is non
+ * zero, reads rx_length bytes after a repeated start. The transaction
+ * structures are owned by the caller and must stay valid until they are
+ * completed, so they are usually static.
+ *
+ * The driver owns TWI_vect and only supports master mode, it can't be linked
+ * together with the split_common I2C slave. While the queue is idle the TWI
+ * interrupt is disabled, which means the blocking i2cmaster routines can
+ * still be used in between, for example to initialise a device. The bus
+ * clock is left to their i2c_init(), which has to run before the first
+ * transaction is queued.
+ */
+#ifndef TWI_ASYNC_H
+#define TWI_ASYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TWI_OK      0x00
+#define TWI_ERROR   0x01
+#define TWI_PENDING 0xFF
+
+struct twi_transaction;
+
+// Called from the TWI interrupt when a transaction completes, it is allowed
+// to queue further transactions
+typedef void (*twi_callback_t)(struct twi_transaction *transaction);
+
+typedef struct twi_transaction {
+    uint8_t address;        // 7 bit slave address
+    const uint8_t *tx;
+    uint8_t tx_length;
+    uint8_t *rx;
+    uint8_t rx_length;
+    twi_callback_t callback;
+    volatile uint8_t status;
+    struct twi_transaction *next;
+} twi_transaction_t;
+
+// Returns false if the transaction is still pending from an earlier call
+bool twi_queue(twi_transaction_t *transaction);
+// Spins until the transaction completes, returns TWI_OK or TWI_ERROR
+uint8_t twi_wait(twi_transaction_t *transaction);
+bool twi_busy(void);
+void twi_wait_idle(void);
+
+#endif
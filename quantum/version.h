@@ -0,0 +1,2 @@
+#define QMK_VERSION "cce31c"
+#define QMK_BUILDDATE "2026-10-19-13:19:37"
@@ -46,6 +46,11 @@ ifeq ($(strip $(MOUSEKEY_ENABLE)), yes)
     TMK_COMMON_DEFS += -DMOUSE_ENABLE
 endif
 
+ifeq ($(strip $(SCAN_DECODER_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/scan_decoder.c
+    TMK_COMMON_DEFS += -DSCAN_DECODER_ENABLE
+endif
+
 ifeq ($(strip $(EXTRAKEY_ENABLE)), yes)
     TMK_COMMON_DEFS += -DEXTRAKEY_ENABLE
 endif
@@ -61,6 +66,15 @@ else
     TMK_COMMON_DEFS += -DNO_DEBUG
 endif
 
+ifeq ($(strip $(BINARY_LOG_ENABLE)), yes)
+ifeq ($(strip $(CONSOLE_ENABLE)), yes)
+ifeq ($(PLATFORM),AVR)
+    TMK_COMMON_SRC += $(PLATFORM_COMMON_DIR)/binlog.c
+    TMK_COMMON_DEFS += -DBINARY_LOG_ENABLE
+endif
+endif
+endif
+
 ifeq ($(strip $(COMMAND_ENABLE)), yes)
     TMK_COMMON_SRC += $(COMMON_DIR)/command.c
     TMK_COMMON_DEFS += -DCOMMAND_ENABLE
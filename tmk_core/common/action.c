@@ -83,18 +83,19 @@ void action_exec(keyevent_t event)
 bool swap_hands = false;
 
 void process_hand_swap(keyevent_t *event) {
-    static swap_state_row_t swap_state[MATRIX_ROWS];
+    static swap_state_row_t swap_state[MATRIX_ROWS][(MATRIX_COLS + SWAP_STATE_ROW_BITS - 1) / SWAP_STATE_ROW_BITS];
 
     keypos_t pos = event->key;
-    swap_state_row_t col_bit = (swap_state_row_t)1<<pos.col;
+    swap_state_row_t *state = &swap_state[pos.row][pos.col / SWAP_STATE_ROW_BITS];
+    swap_state_row_t col_bit = (swap_state_row_t)1<<(pos.col % SWAP_STATE_ROW_BITS);
     bool do_swap = event->pressed ? swap_hands :
-                                    swap_state[pos.row] & (col_bit);
+                                    *state & (col_bit);
 
     if (do_swap) {
         event->key = hand_swap_config[pos.row][pos.col];
-        swap_state[pos.row] |= col_bit;
+        *state |= col_bit;
     } else {
-        swap_state[pos.row] &= ~(col_bit);
+        *state &= ~(col_bit);
     }
 }
 #endif
@@ -74,11 +74,10 @@ extern const keypos_t hand_swap_config[MATRIX_ROWS][MATRIX_COLS];
 typedef  uint8_t    swap_state_row_t;
 #elif (MATRIX_COLS <= 16)
 typedef  uint16_t   swap_state_row_t;
-#elif (MATRIX_COLS <= 32)
-typedef  uint32_t   swap_state_row_t;
 #else
-#error "MATRIX_COLS: invalid value"
+typedef  uint32_t   swap_state_row_t;
 #endif
+#define SWAP_STATE_ROW_BITS (sizeof(swap_state_row_t) * 8)
 
 void process_hand_swap(keyevent_t *record);
 #endif
@@ -0,0 +1,188 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include <avr/interrupt.h>
+#include "sendchar.h"
+#include "binlog.h"
+
+#if (BINLOG_BUFFER_SIZE > 255)
+#   error "BINLOG_BUFFER_SIZE: must be 255 or less"
+#endif
+
+/* Records are kept as their length followed by their bytes */
+static uint8_t buf[BINLOG_BUFFER_SIZE];
+static uint8_t buf_head = 0;
+static uint8_t buf_tail = 0;
+static uint8_t buf_used = 0;
+static uint16_t dropped = 0;
+
+static void buf_put(uint8_t data)
+{
+    buf[buf_head] = data;
+    buf_head = (buf_head + 1) % BINLOG_BUFFER_SIZE;
+}
+
+static uint8_t buf_get(uint8_t index)
+{
+    return buf[(buf_tail + index) % BINLOG_BUFFER_SIZE];
+}
+
+static bool buf_append(const uint8_t *record, uint8_t len)
+{
+    if (buf_used + 1 + len > BINLOG_BUFFER_SIZE)
+        return false;
+    buf_put(len);
+    for (uint8_t i = 0; i < len; i++) buf_put(record[i]);
+    buf_used += 1 + len;
+    return true;
+}
+
+/* may be called from interrupts */
+static void enqueue(const uint8_t *record, uint8_t len)
+{
+    uint8_t sreg = SREG;
+    cli();
+    if (dropped) {
+        // tell the host before the next record that fits
+        uint8_t note[] = { BINLOG_DROPPED, dropped, dropped >> 8 };
+        if (buf_append(note, sizeof(note)))
+            dropped = 0;
+    }
+    if (!record || dropped || !buf_append(record, len)) {
+        if (dropped < 0xFFFF) dropped++;
+    }
+    SREG = sreg;
+}
+
+static bool put_arg(uint8_t *record, uint8_t *len, const void *arg, uint8_t size)
+{
+    if (*len + size > BINLOG_RECORD_SIZE)
+        return false;
+    memcpy(&record[*len], arg, size);
+    *len += size;
+    return true;
+}
+
+/* Walks the format only to take the arguments from the stack in their
+ * sizes, the same way __xprintf() does. */
+void binlog_printf(const char *format_p, ...)
+{
+    uint8_t record[BINLOG_RECORD_SIZE];
+    uint8_t len = 0;
+    bool fits = true;
+    va_list ap;
+
+    record[len++] = BINLOG_PRINTF;
+    record[len++] = (uintptr_t)format_p;
+    record[len++] = (uintptr_t)format_p >> 8;
+
+    va_start(ap, format_p);
+    char c;
+    while (fits && (c = pgm_read_byte(format_p++))) {
+        if (c != '%')
+            continue;
+        c = pgm_read_byte(format_p++);
+        if (c == '%')
+            continue;
+        while (c >= '0' && c <= '9')
+            c = pgm_read_byte(format_p++);
+
+        if (c == 's') {
+            // copied with its 0, cut to what is left of the record
+            const char *s = va_arg(ap, const char *);
+            if (len == BINLOG_RECORD_SIZE) {
+                fits = false;
+                break;
+            }
+            while (*s && len < BINLOG_RECORD_SIZE - 1) record[len++] = *s++;
+            record[len++] = '\0';
+        } else if (c == 'S') {
+            const char *s = va_arg(ap, const char *);
+            fits = put_arg(record, &len, &s, sizeof(s));
+        } else if (c == 'l') {
+            long v = va_arg(ap, long);
+            fits = put_arg(record, &len, &v, sizeof(v));
+            c = pgm_read_byte(format_p++);
+        } else if (c > '9') {
+            int v = va_arg(ap, int);
+            fits = put_arg(record, &len, &v, sizeof(v));
+        }
+
+        // where __xprintf() gives up
+        if (c != 'c' && c != 's' && c != 'S' && c != 'd' && c != 'u' && c != 'X' && c != 'b')
+            break;
+    }
+    va_end(ap);
+
+    // a record too long to keep is only counted
+    enqueue(fits ? record : NULL, len);
+}
+
+void binlog_puts(const char *string_p)
+{
+    uint8_t record[] = { BINLOG_PUTS, (uintptr_t)string_p, (uintptr_t)string_p >> 8 };
+    enqueue(record, sizeof(record));
+}
+
+__attribute__ ((weak))
+uint8_t sendchar_room(void)
+{
+    return 0xFF;
+}
+
+/* COBS frame, a 0 starts and ends it and appears nowhere else. The leading
+ * 0 cuts off a frame that broke off before its end. Returns false when not
+ * even the first byte went out. */
+static bool send_frame(const uint8_t *data, uint8_t len)
+{
+    if (sendchar(0) < 0)
+        return false;
+
+    uint8_t start = 0;
+    while (start <= len) {
+        uint8_t end = start;
+        while (end < len && data[end]) end++;
+        if (sendchar(end - start + 1) < 0)
+            return true;
+        for (uint8_t i = start; i < end; i++) {
+            // the decoder drops the broken frame
+            if (sendchar(data[i]) < 0)
+                return true;
+        }
+        start = end + 1;
+    }
+    sendchar(0);
+    return true;
+}
+
+/* Sends the oldest record once the console can take its whole frame without
+ * waiting, until then it stays in the buffer. */
+void binlog_task(void)
+{
+    uint8_t record[BINLOG_RECORD_SIZE];
+    uint8_t len;
+
+    uint8_t sreg = SREG;
+    cli();
+    if (!buf_used) {
+        SREG = sreg;
+        return;
+    }
+    len = buf_get(0);
+    for (uint8_t i = 0; i < len; i++) record[i] = buf_get(1 + i);
+    SREG = sreg;
+
+    // the record, its COBS code bytes and the two delimiters
+    if (sendchar_room() < len + 3)
+        return;
+    if (!send_frame(record, len))
+        return;
+
+    sreg = SREG;
+    cli();
+    buf_tail = (buf_tail + 1 + len) % BINLOG_BUFFER_SIZE;
+    buf_used -= 1 + len;
+    SREG = sreg;
+}
@@ -0,0 +1,53 @@
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stdint.h>
+
+/*
+ * Binary log
+ *
+ * With BINARY_LOG_ENABLE print(), xprintf() and the debug macros built on
+ * them don't render text on the keyboard. They put the address of the
+ * format string and the raw arguments into a RAM buffer, binlog_task()
+ * sends one record at a time from keyboard_task, once the console can take
+ * it without waiting. Records go out as COBS frames between 0 bytes,
+ * util/binlog_decode.py turns them back into text with the strings in the
+ * ELF file:
+ *
+ *   $ hid_listen | util/binlog_decode.py .build/<keyboard>_<keymap>.elf
+ *
+ * A '%s' argument is copied into the record, '%S' strings are looked up
+ * in the ELF file.
+ */
+
+#ifndef BINLOG_BUFFER_SIZE
+#define BINLOG_BUFFER_SIZE  128
+#endif
+
+/* longest record, format address and arguments included. Its frame is 3
+ * bytes longer and has to fit in the console endpoint, 32 bytes on LUFA. */
+#ifndef BINLOG_RECORD_SIZE
+#define BINLOG_RECORD_SIZE  24
+#endif
+
+/* first byte of a record */
+#define BINLOG_PRINTF   'P'     // format address, arguments
+#define BINLOG_PUTS     'S'     // string address
+#define BINLOG_DROPPED  'D'     // count of records lost to a full buffer
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void binlog_printf(const char *format_p, ...);
+void binlog_puts(const char *string_p);
+void binlog_task(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define __xprintf   binlog_printf
+#define xputs       binlog_puts
+
+#endif
@@ -105,9 +105,12 @@ void bootmagic(void)
 static bool scan_keycode(uint8_t keycode)
 {
     for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
-        matrix_row_t matrix_row = matrix_get_row(r);
+        matrix_row_t matrix_row = 0;
         for (uint8_t c = 0; c < MATRIX_COLS; c++) {
-            if (matrix_row & ((matrix_row_t)1<<c)) {
+            if (c % MATRIX_ROW_WORD_BITS == 0) {
+                matrix_row = matrix_get_row_word(r, c / MATRIX_ROW_WORD_BITS);
+            }
+            if (matrix_row & ((matrix_row_t)1<<(c % MATRIX_ROW_WORD_BITS))) {
                 if (keycode == keymap_key_to_keycode(0, (keypos_t){ .row = r, .col = c })) {
                     return true;
                 }
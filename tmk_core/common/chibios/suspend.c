@@ -35,7 +35,9 @@ bool suspend_wakeup_condition(void)
     matrix_scan();
     matrix_power_down();
     for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
-        if (matrix_get_row(r)) return true;
+        for (uint8_t w = 0; w < MATRIX_ROW_WORDS; w++) {
+            if (matrix_get_row_word(r, w)) return true;
+        }
     }
     return false;
 }
@@ -1,56 +1,223 @@
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "eeprom.h"
 #include "eeconfig.h"
+#include "progmem.h"
 
-void eeconfig_init(void)
+typedef struct {
+    uint8_t id_version;
+    uint8_t size;
+    uint8_t offset;
+    uint8_t fill;
+} eeconfig_record_t;
+
+#define RECORD(field, id, version, fill) \
+    { (id) << 4 | (version), sizeof(((eeconfig_t *)0)->field), offsetof(eeconfig_t, field), fill }
+
+static const eeconfig_record_t records[] PROGMEM = {
+    RECORD(debug,           EECONFIG_RECORD_DEBUG,          1, 0),
+    RECORD(default_layer,   EECONFIG_RECORD_DEFAULT_LAYER,  1, 0),
+    RECORD(keymap,          EECONFIG_RECORD_KEYMAP,         1, 0),
+    RECORD(mousekey_accel,  EECONFIG_RECORD_MOUSEKEY_ACCEL, 1, 0),
+#ifdef BACKLIGHT_ENABLE
+    RECORD(backlight,       EECONFIG_RECORD_BACKLIGHT,      1, 0),
+#endif
+#ifdef AUDIO_ENABLE
+    RECORD(audio,           EECONFIG_RECORD_AUDIO,          1, 0xFF), // On by default
+#endif
+#ifdef RGBLIGHT_ENABLE
+    RECORD(rgblight,        EECONFIG_RECORD_RGBLIGHT,       1, 0),
+#endif
+#ifdef EE_HANDS
+    RECORD(handedness,      EECONFIG_RECORD_HANDEDNESS,     1, 0),
+#endif
+};
+
+#define RECORD_COUNT (sizeof(records) / sizeof(records[0]))
+
+typedef char eeconfig_fits[sizeof(eeconfig_t) <= EECONFIG_SIZE ? 1 : -1];
+
+static eeconfig_t eeconfig;
+static bool eeconfig_loaded = false;
+
+static void eeconfig_defaults(void)
+{
+    for (uint8_t i = 0; i < RECORD_COUNT; i++) {
+        uint8_t *data = (uint8_t *)&eeconfig + pgm_read_byte(&records[i].offset);
+        eeconfig_header_t *header = (eeconfig_header_t *)(data - sizeof(eeconfig_header_t));
+        header->id_version = pgm_read_byte(&records[i].id_version);
+        header->size = pgm_read_byte(&records[i].size);
+        memset(data, pgm_read_byte(&records[i].fill), header->size);
+    }
+    eeconfig.end = 0xFF;
+}
+
+/* Converts a stored record of an older version into the current one, add a
+ * case here when a record's version goes up. Returning false leaves the
+ * default in place. */
+static bool migrate_record(uint8_t id, uint8_t version, const uint8_t *stored, uint8_t stored_size, uint8_t *data)
+{
+    switch (id) {
+        default:
+            return false;
+    }
+}
+
+static void load_records(const uint8_t *stored)
+{
+    uint8_t offset = sizeof(eeconfig.magic);
+    while (offset + sizeof(eeconfig_header_t) <= EECONFIG_SIZE) {
+        uint8_t id = stored[offset] >> 4;
+        uint8_t version = stored[offset] & 0x0F;
+        uint8_t size = stored[offset + 1];
+        offset += sizeof(eeconfig_header_t);
+        if (id == 0 || id == 0x0F || offset + size > EECONFIG_SIZE) {
+            break;
+        }
+        for (uint8_t i = 0; i < RECORD_COUNT; i++) {
+            uint8_t id_version = pgm_read_byte(&records[i].id_version);
+            if ((id_version >> 4) != id) {
+                continue;
+            }
+            uint8_t *data = (uint8_t *)&eeconfig + pgm_read_byte(&records[i].offset);
+            uint8_t record_size = pgm_read_byte(&records[i].size);
+            if (version == (id_version & 0x0F)) {
+                // a record that grew keeps the defaults of its new bytes
+                memcpy(data, &stored[offset], size < record_size ? size : record_size);
+            } else {
+                migrate_record(id, version, &stored[offset], size, data);
+            }
+            break;
+        }
+        offset += size;
+    }
+}
+
+static void load_legacy(const uint8_t *stored)
 {
-    eeprom_update_word(EECONFIG_MAGIC,          EECONFIG_MAGIC_NUMBER);
-    eeprom_update_byte(EECONFIG_DEBUG,          0);
-    eeprom_update_byte(EECONFIG_DEFAULT_LAYER,  0);
-    eeprom_update_byte(EECONFIG_KEYMAP,         0);
-    eeprom_update_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
+    eeconfig.debug = stored[2];
+    eeconfig.default_layer = stored[3];
+    eeconfig.keymap = stored[4];
+    eeconfig.mousekey_accel = stored[5];
 #ifdef BACKLIGHT_ENABLE
-    eeprom_update_byte(EECONFIG_BACKLIGHT,      0);
+    eeconfig.backlight = stored[6];
 #endif
 #ifdef AUDIO_ENABLE
-    eeprom_update_byte(EECONFIG_AUDIO,             0xFF); // On by default
+    eeconfig.audio = stored[7];
 #endif
 #ifdef RGBLIGHT_ENABLE
-    eeprom_update_dword(EECONFIG_RGBLIGHT,      0);
+    eeconfig.rgblight = stored[8] | ((uint32_t)stored[9] << 8) |
+                        ((uint32_t)stored[10] << 16) | ((uint32_t)stored[11] << 24);
+#endif
+}
+
+static void eeconfig_load(void)
+{
+    if (eeconfig_loaded) {
+        return;
+    }
+    eeconfig_loaded = true;
+
+    // one sequential read of the whole store
+    uint8_t stored[EECONFIG_SIZE];
+    eeprom_read_block(stored, EECONFIG_MAGIC, sizeof(stored));
+    uint16_t magic = stored[0] | (stored[1] << 8);
+
+    eeconfig_defaults();
+    if (magic == EECONFIG_MAGIC_NUMBER) {
+        load_records(stored);
+    } else {
+        if (magic == EECONFIG_LEGACY_MAGIC_NUMBER) {
+            load_legacy(stored);
+        }
+#ifdef EE_HANDS
+        // the eeprom-*hand.eep files set byte 10 without a magic number
+        eeconfig.handedness = stored[10];
+#endif
+    }
+
+    if (magic == EECONFIG_MAGIC_NUMBER || magic == EECONFIG_LEGACY_MAGIC_NUMBER) {
+        eeconfig.magic = EECONFIG_MAGIC_NUMBER;
+        // only rewritten when the layout changed
+        if (memcmp(stored, &eeconfig, sizeof(eeconfig))) {
+            eeprom_update_block(&eeconfig, EECONFIG_MAGIC, sizeof(eeconfig));
+        }
+    } else {
+        // stays disabled until eeconfig_init()
+        eeconfig.magic = magic;
+    }
+}
+
+void eeconfig_init(void)
+{
+    eeconfig_load();
+#ifdef EE_HANDS
+    // describes the hardware rather than a setting, so it survives a reset
+    uint8_t handedness = eeconfig.handedness;
+#endif
+    eeconfig_defaults();
+#ifdef EE_HANDS
+    eeconfig.handedness = handedness;
 #endif
+    eeconfig.magic = EECONFIG_MAGIC_NUMBER;
+    eeprom_update_block(&eeconfig, EECONFIG_MAGIC, sizeof(eeconfig));
 }
 
 void eeconfig_enable(void)
 {
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+    eeconfig_load();
+    eeconfig.magic = EECONFIG_MAGIC_NUMBER;
+    eeprom_update_block(&eeconfig, EECONFIG_MAGIC, sizeof(eeconfig));
 }
 
 void eeconfig_disable(void)
 {
+    eeconfig_load();
+    eeconfig.magic = 0xFFFF;
     eeprom_update_word(EECONFIG_MAGIC, 0xFFFF);
 }
 
 bool eeconfig_is_enabled(void)
 {
-    return (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER);
+    eeconfig_load();
+    return (eeconfig.magic == EECONFIG_MAGIC_NUMBER);
+}
+
+void eeconfig_update_block(const void *src, void *addr, uint8_t size)
+{
+    eeconfig_load();
+    uintptr_t offset = (uintptr_t)addr;
+    if (offset + size <= sizeof(eeconfig)) {
+        memcpy((uint8_t *)&eeconfig + offset, src, size);
+    }
+    eeprom_update_block(src, addr, size);
 }
 
-uint8_t eeconfig_read_debug(void)      { return eeprom_read_byte(EECONFIG_DEBUG); }
-void eeconfig_update_debug(uint8_t val) { eeprom_update_byte(EECONFIG_DEBUG, val); }
+uint8_t eeconfig_read_debug(void)      { eeconfig_load(); return eeconfig.debug; }
+void eeconfig_update_debug(uint8_t val) { eeconfig_update_block(&val, EECONFIG_DEBUG, sizeof(val)); }
 
-uint8_t eeconfig_read_default_layer(void)      { return eeprom_read_byte(EECONFIG_DEFAULT_LAYER); }
-void eeconfig_update_default_layer(uint8_t val) { eeprom_update_byte(EECONFIG_DEFAULT_LAYER, val); }
+uint8_t eeconfig_read_default_layer(void)      { eeconfig_load(); return eeconfig.default_layer; }
+void eeconfig_update_default_layer(uint8_t val) { eeconfig_update_block(&val, EECONFIG_DEFAULT_LAYER, sizeof(val)); }
 
-uint8_t eeconfig_read_keymap(void)      { return eeprom_read_byte(EECONFIG_KEYMAP); }
-void eeconfig_update_keymap(uint8_t val) { eeprom_update_byte(EECONFIG_KEYMAP, val); }
+uint8_t eeconfig_read_keymap(void)      { eeconfig_load(); return eeconfig.keymap; }
+void eeconfig_update_keymap(uint8_t val) { eeconfig_update_block(&val, EECONFIG_KEYMAP, sizeof(val)); }
 
 #ifdef BACKLIGHT_ENABLE
-uint8_t eeconfig_read_backlight(void)      { return eeprom_read_byte(EECONFIG_BACKLIGHT); }
-void eeconfig_update_backlight(uint8_t val) { eeprom_update_byte(EECONFIG_BACKLIGHT, val); }
+uint8_t eeconfig_read_backlight(void)      { eeconfig_load(); return eeconfig.backlight; }
+void eeconfig_update_backlight(uint8_t val) { eeconfig_update_block(&val, EECONFIG_BACKLIGHT, sizeof(val)); }
 #endif
 
 #ifdef AUDIO_ENABLE
-uint8_t eeconfig_read_audio(void)      { return eeprom_read_byte(EECONFIG_AUDIO); }
-void eeconfig_update_audio(uint8_t val) { eeprom_update_byte(EECONFIG_AUDIO, val); }
+uint8_t eeconfig_read_audio(void)      { eeconfig_load(); return eeconfig.audio; }
+void eeconfig_update_audio(uint8_t val) { eeconfig_update_block(&val, EECONFIG_AUDIO, sizeof(val)); }
+#endif
+
+#ifdef RGBLIGHT_ENABLE
+uint32_t eeconfig_read_rgblight(void)      { eeconfig_load(); return eeconfig.rgblight; }
+void eeconfig_update_rgblight(uint32_t val) { eeconfig_update_block(&val, EECONFIG_RGBLIGHT, sizeof(val)); }
+#endif
+
+#ifdef EE_HANDS
+uint8_t eeconfig_read_handedness(void) { eeconfig_load(); return eeconfig.handedness; }
 #endif
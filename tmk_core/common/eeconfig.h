@@ -20,19 +20,91 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdint.h>
 #include <stdbool.h>
-
-
-#define EECONFIG_MAGIC_NUMBER                       (uint16_t)0xFEED
+#include <stddef.h>
+
+
+#define EECONFIG_MAGIC_NUMBER                       (uint16_t)0xFEEE
+/* fixed address layout used before the record store */
+#define EECONFIG_LEGACY_MAGIC_NUMBER                (uint16_t)0xFEED
+
+/* Config record store
+ *
+ * After the magic number every setting is stored as a record: a header
+ * with its id, version and size, followed by its data. The whole store is
+ * read into eeconfig at the first access, and the eeconfig_read_*()
+ * functions only read RAM afterwards.
+ *
+ * Records are matched by id when the store is loaded, so adding a record,
+ * enabling a feature or growing a record keeps the other settings. A record
+ * whose version went up is converted by migrate_record() in eeconfig.c, or
+ * gets its default. A store in the old fixed layout is migrated as well.
+ */
+
+#define EECONFIG_SIZE                               32
+
+#define EECONFIG_RECORD_DEBUG                       1
+#define EECONFIG_RECORD_DEFAULT_LAYER               2
+#define EECONFIG_RECORD_KEYMAP                      3
+#define EECONFIG_RECORD_MOUSEKEY_ACCEL              4
+#define EECONFIG_RECORD_BACKLIGHT                   5
+#define EECONFIG_RECORD_AUDIO                       6
+#define EECONFIG_RECORD_RGBLIGHT                    7
+#define EECONFIG_RECORD_HANDEDNESS                  8
+
+/* id in the high nibble, version in the low one; an id of 0 or 15 ends the
+ * store, which covers erased and zeroed EEPROM */
+typedef struct {
+    uint8_t id_version;
+    uint8_t size;
+} __attribute__ ((packed)) eeconfig_header_t;
+
+typedef struct {
+    uint16_t magic;
+    eeconfig_header_t debug_header;
+    uint8_t debug;
+    eeconfig_header_t default_layer_header;
+    uint8_t default_layer;
+    eeconfig_header_t keymap_header;
+    uint8_t keymap;
+    eeconfig_header_t mousekey_accel_header;
+    uint8_t mousekey_accel;
+#ifdef BACKLIGHT_ENABLE
+    eeconfig_header_t backlight_header;
+    uint8_t backlight;
+#endif
+#ifdef AUDIO_ENABLE
+    eeconfig_header_t audio_header;
+    uint8_t audio;
+#endif
+#ifdef RGBLIGHT_ENABLE
+    eeconfig_header_t rgblight_header;
+    uint32_t rgblight;
+#endif
+#ifdef EE_HANDS
+    eeconfig_header_t handedness_header;
+    uint8_t handedness;
+#endif
+    uint8_t end;
+} __attribute__ ((packed)) eeconfig_t;
 
 /* eeprom parameteter address */
-#define EECONFIG_MAGIC                              (uint16_t *)0
-#define EECONFIG_DEBUG                              (uint8_t *)2
-#define EECONFIG_DEFAULT_LAYER                      (uint8_t *)3
-#define EECONFIG_KEYMAP                             (uint8_t *)4
-#define EECONFIG_MOUSEKEY_ACCEL                     (uint8_t *)5
-#define EECONFIG_BACKLIGHT                          (uint8_t *)6
-#define EECONFIG_AUDIO                              (uint8_t *)7
-#define EECONFIG_RGBLIGHT                           (uint32_t *)8
+#define EECONFIG_MAGIC                              (uint16_t *)offsetof(eeconfig_t, magic)
+#define EECONFIG_DEBUG                              (uint8_t *)offsetof(eeconfig_t, debug)
+#define EECONFIG_DEFAULT_LAYER                      (uint8_t *)offsetof(eeconfig_t, default_layer)
+#define EECONFIG_KEYMAP                             (uint8_t *)offsetof(eeconfig_t, keymap)
+#define EECONFIG_MOUSEKEY_ACCEL                     (uint8_t *)offsetof(eeconfig_t, mousekey_accel)
+#ifdef BACKLIGHT_ENABLE
+#define EECONFIG_BACKLIGHT                          (uint8_t *)offsetof(eeconfig_t, backlight)
+#endif
+#ifdef AUDIO_ENABLE
+#define EECONFIG_AUDIO                              (uint8_t *)offsetof(eeconfig_t, audio)
+#endif
+#ifdef RGBLIGHT_ENABLE
+#define EECONFIG_RGBLIGHT                           (uint32_t *)offsetof(eeconfig_t, rgblight)
+#endif
+#ifdef EE_HANDS
+#define EECONFIG_HANDEDNESS                         (uint8_t *)offsetof(eeconfig_t, handedness)
+#endif
 
 
 /* debug bit */
@@ -79,4 +151,16 @@ uint8_t eeconfig_read_audio(void);
 void eeconfig_update_audio(uint8_t val);
 #endif
 
+#ifdef RGBLIGHT_ENABLE
+uint32_t eeconfig_read_rgblight(void);
+void eeconfig_update_rgblight(uint32_t val);
+#endif
+
+#ifdef EE_HANDS
+uint8_t eeconfig_read_handedness(void);
+#endif
+
+/* Writes size bytes at an eeconfig address, keeping the RAM copy current */
+void eeconfig_update_block(const void *src, void *addr, uint8_t size);
+
 #endif
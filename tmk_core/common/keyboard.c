@@ -60,24 +60,70 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef VISUALIZER_ENABLE
 #   include "visualizer/visualizer.h"
 #endif
+#ifdef SCAN_DECODER_ENABLE
+#   include "scan_decoder.h"
+#endif
 
 
 
 #ifdef MATRIX_HAS_GHOST
-static bool has_ghost_in_row(uint8_t row)
+/* Number of rows that are down on each column, and a mask of the columns
+ * that are down on more than one row. They are updated from the keys that
+ * changed since the last scan, so checking a row doesn't look at the others.
+ */
+static matrix_row_t matrix_raw[MATRIX_ROWS][MATRIX_ROW_WORDS];
+static uint8_t col_count[MATRIX_COLS];
+static matrix_row_t shared_cols[MATRIX_ROW_WORDS];
+
+static void update_ghost_counts(void)
 {
-    matrix_row_t matrix_row = matrix_get_row(row);
-    // No ghost exists when less than 2 keys are down on the row
-    if (((matrix_row - 1) & matrix_row) == 0)
-        return false;
-
-    // Ghost occurs when the row shares column line with other row
-    for (uint8_t i=0; i < MATRIX_ROWS; i++) {
-        if (i != row && (matrix_get_row(i) & matrix_row))
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        for (uint8_t w = 0; w < MATRIX_ROW_WORDS; w++) {
+            matrix_row_t matrix_row = matrix_get_row_word(r, w);
+            matrix_row_t change = matrix_row ^ matrix_raw[r][w];
+            if (!change)
+                continue;
+            matrix_raw[r][w] = matrix_row;
+            for (uint8_t c = 0; change; c++, change >>= 1) {
+                if (!(change & 1))
+                    continue;
+                matrix_row_t col = (matrix_row_t)1<<c;
+                uint8_t *count = &col_count[w * MATRIX_ROW_WORD_BITS + c];
+                if (matrix_row & col) {
+                    if (++*count == 2) shared_cols[w] |= col;
+                } else {
+                    if (--*count == 1) shared_cols[w] &= ~col;
+                }
+            }
+        }
+    }
+}
+
+/* No ghost exists when less than 2 keys are down on the row */
+static bool has_multiple_keys(uint8_t row)
+{
+    bool any = false;
+    for (uint8_t w = 0; w < MATRIX_ROW_WORDS; w++) {
+        matrix_row_t matrix_row = matrix_raw[row][w];
+        if (!matrix_row)
+            continue;
+        if (any || ((matrix_row - 1) & matrix_row))
             return true;
+        any = true;
     }
     return false;
 }
+
+__attribute__ ((weak))
+void matrix_ghost_event(uint8_t row, uint8_t word, matrix_row_t cols) {
+}
+#endif
+
+#if (MATRIX_ROW_WORDS > 1)
+__attribute__ ((weak))
+matrix_row_t matrix_get_row(uint8_t row) {
+    return matrix_get_row_word(row, 0);
+}
 #endif
 
 __attribute__ ((weak))
@@ -125,49 +171,72 @@ void keyboard_init(void) {
  */
 void keyboard_task(void)
 {
-    static matrix_row_t matrix_prev[MATRIX_ROWS];
+#ifndef SCAN_DECODER_ENABLE
+    static matrix_row_t matrix_prev[MATRIX_ROWS][MATRIX_ROW_WORDS];
 #ifdef MATRIX_HAS_GHOST
-    static matrix_row_t matrix_ghost[MATRIX_ROWS];
+    static matrix_row_t matrix_ghost[MATRIX_ROWS][MATRIX_ROW_WORDS];
 #endif
-    static uint8_t led_status = 0;
     matrix_row_t matrix_row = 0;
     matrix_row_t matrix_change = 0;
+#endif
+    static uint8_t led_status = 0;
 
     matrix_scan();
+#ifdef SCAN_DECODER_ENABLE
+    // converters send the events as the scan codes are decoded
+    if (scan_decoder_task())
+        goto MATRIX_LOOP_END;
+#else
+#ifdef MATRIX_HAS_GHOST
+    update_ghost_counts();
+#endif
     for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
-        matrix_row = matrix_get_row(r);
-        matrix_change = matrix_row ^ matrix_prev[r];
-        if (matrix_change) {
 #ifdef MATRIX_HAS_GHOST
-            if (has_ghost_in_row(r)) {
-                /* Keep track of whether ghosted status has changed for
-                 * debugging. But don't update matrix_prev until un-ghosted, or
-                 * the last key would be lost.
-                 */
-                if (debug_matrix && matrix_ghost[r] != matrix_row) {
-                    matrix_print();
-                }
-                matrix_ghost[r] = matrix_row;
-                continue;
+        bool multiple_keys = has_multiple_keys(r);
+        bool ghosted = false;
+        for (uint8_t w = 0; w < MATRIX_ROW_WORDS; w++) {
+            // Ghost occurs when the row shares column line with other row
+            matrix_row_t ghost = multiple_keys ? matrix_raw[r][w] & shared_cols[w] : 0;
+            if (matrix_ghost[r][w] != ghost) {
+                if (debug_matrix) matrix_print();
+                matrix_ghost[r][w] = ghost;
+                matrix_ghost_event(r, w, ghost);
             }
-            matrix_ghost[r] = matrix_row;
+            ghosted |= (ghost != 0);
+        }
+#if MATRIX_GHOST_POLICY == MATRIX_GHOST_BLOCK_ROW
+        /* Don't update matrix_prev until un-ghosted, or the last key would
+         * be lost. */
+        if (ghosted)
+            continue;
+#endif
+#endif
+        for (uint8_t w = 0; w < MATRIX_ROW_WORDS; w++) {
+            matrix_row = matrix_get_row_word(r, w);
+            matrix_change = matrix_row ^ matrix_prev[r][w];
+#if defined(MATRIX_HAS_GHOST) && MATRIX_GHOST_POLICY == MATRIX_GHOST_BLOCK_KEY
+            /* Releases and keys on columns no other row uses are real */
+            matrix_change &= ~matrix_ghost[r][w];
 #endif
+            if (!matrix_change)
+                continue;
             if (debug_matrix) matrix_print();
-            for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+            for (uint8_t c = 0; c < MATRIX_ROW_WORD_BITS; c++) {
                 if (matrix_change & ((matrix_row_t)1<<c)) {
                     action_exec((keyevent_t){
-                        .key = (keypos_t){ .row = r, .col = c },
+                        .key = (keypos_t){ .row = r, .col = w * MATRIX_ROW_WORD_BITS + c },
                         .pressed = (matrix_row & ((matrix_row_t)1<<c)),
                         .time = (timer_read() | 1) /* time should not be 0 */
                     });
                     // record a processed key
-                    matrix_prev[r] ^= ((matrix_row_t)1<<c);
+                    matrix_prev[r][w] ^= ((matrix_row_t)1<<c);
                     // process a key per task call
                     goto MATRIX_LOOP_END;
                 }
             }
         }
     }
+#endif
     // call with pseudo tick event when no real key event.
     action_exec(TICK);
 
@@ -194,6 +263,10 @@ MATRIX_LOOP_END:
 	serial_link_update();
 #endif
 
+#ifdef BINARY_LOG_ENABLE
+    binlog_task();
+#endif
+
 #ifdef VISUALIZER_ENABLE
     visualizer_update(default_layer_state, layer_state, visualizer_get_mods(), host_keyboard_leds());
 #endif
@@ -27,10 +27,19 @@ typedef  uint8_t    matrix_row_t;
 typedef  uint16_t   matrix_row_t;
 #elif (MATRIX_COLS <= 32)
 typedef  uint32_t   matrix_row_t;
+#elif (MATRIX_COLS <= 255)
+/* Wider rows are kept as several words, word n holds columns 32n to 32n+31 */
+typedef  uint32_t   matrix_row_t;
+#   define MATRIX_ROW_WORDS ((MATRIX_COLS + 31) / 32)
 #else
 #error "MATRIX_COLS: invalid value"
 #endif
 
+#ifndef MATRIX_ROW_WORDS
+#   define MATRIX_ROW_WORDS 1
+#endif
+#define MATRIX_ROW_WORD_BITS    (sizeof(matrix_row_t) * 8)
+
 #define MATRIX_IS_ON(row, col)  (matrix_get_row(row) && (1<<col))
 
 
@@ -54,6 +63,13 @@ bool matrix_is_modified(void) __attribute__ ((deprecated));
 bool matrix_is_on(uint8_t row, uint8_t col);
 /* matrix state on row */
 matrix_row_t matrix_get_row(uint8_t row);
+/* matrix state on a word of the row, a matrix wider than 32 columns provides
+ * this and gets matrix_get_row() for free */
+#if (MATRIX_ROW_WORDS > 1)
+matrix_row_t matrix_get_row_word(uint8_t row, uint8_t word);
+#else
+#   define matrix_get_row_word(row, word) matrix_get_row(row)
+#endif
 /* print matrix for debug */
 void matrix_print(void);
 
@@ -72,6 +88,24 @@ void matrix_scan_kb(void);
 void matrix_init_user(void);
 void matrix_scan_user(void);
 
+#ifdef MATRIX_HAS_GHOST
+/* What keyboard_task does with a row of two or more keys that shares a
+ * column with another row:
+ *   MATRIX_GHOST_BLOCK_ROW  hold back every change on the row until it's clear (default)
+ *   MATRIX_GHOST_BLOCK_KEY  hold back only presses on the shared columns
+ *   MATRIX_GHOST_REPORT     process every change, just call matrix_ghost_event()
+ */
+#define MATRIX_GHOST_BLOCK_ROW  0
+#define MATRIX_GHOST_BLOCK_KEY  1
+#define MATRIX_GHOST_REPORT     2
+#ifndef MATRIX_GHOST_POLICY
+#define MATRIX_GHOST_POLICY     MATRIX_GHOST_BLOCK_ROW
+#endif
+/* called when the ghosted columns of a row change, cols is 0 once it's clear.
+ * word is always 0 unless MATRIX_COLS > 32. */
+void matrix_ghost_event(uint8_t row, uint8_t word, matrix_row_t cols);
+#endif
+
 #ifdef I2C_SPLIT
 	void slave_matrix_init(void);
 	uint8_t slave_matrix_scan(void);
@@ -16,6 +16,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "keycode.h"
 #include "host.h"
 #include "timer.h"
@@ -26,7 +27,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 static report_mouse_t mouse_report = {};
-static uint8_t mousekey_repeat =  0;
+/* direction each axis is held in: -1, 0 or 1 */
+static int8_t move_x = 0, move_y = 0, wheel_v = 0, wheel_h = 0;
+/* motion not reported yet, in 1/256 counts */
+static int16_t rem_x = 0, rem_y = 0, rem_v = 0, rem_h = 0;
+static bool mousekey_repeat = false;
+/* milliseconds since repeated motion started */
+static uint16_t mousekey_time = 0;
 static uint8_t mousekey_accel = 0;
 
 static void mousekey_debug(void);
@@ -36,7 +43,11 @@ static void mousekey_debug(void);
  * Mouse keys  acceleration algorithm
  *  http://en.wikipedia.org/wiki/Mouse_keys
  *
- *  speed = delta * max_speed * (repeat / time_to_max)**((1000+curve)/1000)
+ * Speeds are kept in 1/256 counts per millisecond and motion is integrated
+ * over the time that actually passed since the last report, so the cursor
+ * moves at the same rate however often mousekey_task() runs. The fraction
+ * of a count left over is carried to the next report, which keeps slow
+ * movement smooth instead of stepping between whole counts.
  */
 /* milliseconds between the initial key press and first repeated motion event (0-2550) */
 uint8_t mk_delay = MOUSEKEY_DELAY/10;
@@ -46,8 +57,8 @@ uint8_t mk_interval = MOUSEKEY_INTERVAL;
 uint8_t mk_max_speed = MOUSEKEY_MAX_SPEED;
 /* number of events (count) accelerating to steady speed (0-255) */
 uint8_t mk_time_to_max = MOUSEKEY_TIME_TO_MAX;
-/* ramp used to reach maximum pointer speed (NOT SUPPORTED) */
-//int8_t mk_curve = 0;
+/* ramp used to reach maximum pointer speed, MOUSEKEY_CURVE_* */
+uint8_t mk_curve = MOUSEKEY_CURVE;
 /* wheel params */
 uint8_t mk_wheel_max_speed = MOUSEKEY_WHEEL_MAX_SPEED;
 uint8_t mk_wheel_time_to_max = MOUSEKEY_WHEEL_TIME_TO_MAX;
@@ -55,86 +66,182 @@ uint8_t mk_wheel_time_to_max = MOUSEKEY_WHEEL_TIME_TO_MAX;
 
 static uint16_t last_timer = 0;
 
+#define SPEED_MAX ((uint16_t)MOUSEKEY_MOVE_MAX << 8)
 
-static uint8_t move_unit(void)
+/* kinetic curve: current pointer speed, and the direction it coasts in once
+ * the keys are released */
+static uint16_t kinetic_speed = 0;
+static int8_t coast_x = 0, coast_y = 0;
+
+
+static uint8_t interval(void)
+{
+    return mk_interval ? mk_interval : 1;
+}
+
+/* delta * max_speed counts per interval, as 1/256 counts per ms */
+static uint16_t max_speed(uint8_t delta, uint8_t max)
+{
+    uint32_t speed = ((uint32_t)delta * max << 8) / interval();
+    return speed > SPEED_MAX ? SPEED_MAX : speed;
+}
+
+static uint16_t ramp_speed(uint16_t max, uint8_t time_to_max, uint8_t curve)
 {
-    uint16_t unit;
+    uint32_t ramp = (uint32_t)time_to_max * interval();
+    uint32_t speed;
+
     if (mousekey_accel & (1<<0)) {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed)/4;
+        return max / 4;
     } else if (mousekey_accel & (1<<1)) {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed)/2;
+        return max / 2;
     } else if (mousekey_accel & (1<<2)) {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed);
-    } else if (mousekey_repeat == 0) {
-        unit = MOUSEKEY_MOVE_DELTA;
-    } else if (mousekey_repeat >= mk_time_to_max) {
-        unit = MOUSEKEY_MOVE_DELTA * mk_max_speed;
+        return max;
+    }
+
+    if (mousekey_time >= ramp) {
+        speed = max;
+    } else if (curve == MOUSEKEY_CURVE_QUADRATIC) {
+        speed = (uint32_t)max * mousekey_time / ramp * mousekey_time / ramp;
     } else {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed * mousekey_repeat) / mk_time_to_max;
+        speed = (uint32_t)max * mousekey_time / ramp;
     }
-    return (unit > MOUSEKEY_MOVE_MAX ? MOUSEKEY_MOVE_MAX : (unit == 0 ? 1 : unit));
+    // at least one count per interval
+    uint16_t min = 256 / interval();
+    return speed < min ? min : speed;
 }
 
-static uint8_t wheel_unit(void)
+static uint16_t move_speed(uint16_t elapsed)
 {
-    uint16_t unit;
-    if (mousekey_accel & (1<<0)) {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed)/4;
-    } else if (mousekey_accel & (1<<1)) {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed)/2;
-    } else if (mousekey_accel & (1<<2)) {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed);
-    } else if (mousekey_repeat == 0) {
-        unit = MOUSEKEY_WHEEL_DELTA;
-    } else if (mousekey_repeat >= mk_wheel_time_to_max) {
-        unit = MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed;
-    } else {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed * mousekey_repeat) / mk_wheel_time_to_max;
+    uint16_t max = max_speed(MOUSEKEY_MOVE_DELTA, mk_max_speed);
+    if (mk_curve != MOUSEKEY_CURVE_KINETIC || mousekey_accel) {
+        return ramp_speed(max, mk_time_to_max, mk_curve);
     }
-    return (unit > MOUSEKEY_WHEEL_MAX ? MOUSEKEY_WHEEL_MAX : (unit == 0 ? 1 : unit));
+
+    // eases towards full speed while a key is held and back to rest after
+    uint16_t target = (move_x || move_y) ? max : 0;
+    uint32_t ramp = (uint32_t)mk_time_to_max * interval();
+    if (ramp == 0) {
+        kinetic_speed = target;
+    } else if (kinetic_speed < target) {
+        uint16_t gap = target - kinetic_speed;
+        uint32_t step = ((uint32_t)gap * elapsed) / ramp + 1;
+        kinetic_speed = step >= gap ? target : kinetic_speed + step;
+    } else if (kinetic_speed > target) {
+        // slows down four times as fast as it speeds up
+        uint16_t gap = kinetic_speed - target;
+        uint32_t step = ((uint32_t)gap * elapsed * 4) / ramp + 1;
+        kinetic_speed = step >= gap ? target : kinetic_speed - step;
+    }
+    return kinetic_speed;
+}
+
+static uint16_t wheel_speed(void)
+{
+    return ramp_speed(max_speed(MOUSEKEY_WHEEL_DELTA, mk_wheel_max_speed), mk_wheel_time_to_max,
+                      mk_curve == MOUSEKEY_CURVE_QUADRATIC ? MOUSEKEY_CURVE_QUADRATIC : MOUSEKEY_CURVE_LINEAR);
+}
+
+/* 1/256 counts covered at speed in elapsed ms */
+static uint16_t travel(uint16_t speed, uint16_t elapsed)
+{
+    uint32_t distance = (uint32_t)speed * elapsed;
+    return distance > SPEED_MAX ? SPEED_MAX : distance;
+}
+
+/* Adds distance (1/256 counts) in direction dir to the remainder and
+ * returns the whole counts to report */
+static int8_t advance(int16_t *remainder, int8_t dir, uint16_t distance)
+{
+    if (!dir) {
+        *remainder = 0;
+        return 0;
+    }
+    int16_t total = *remainder + (dir > 0 ? (int16_t)distance : -(int16_t)distance);
+    int16_t counts = total / 256;
+    if (counts > MOUSEKEY_MOVE_MAX) {
+        *remainder = 0;
+        return MOUSEKEY_MOVE_MAX;
+    }
+    if (counts < -MOUSEKEY_MOVE_MAX) {
+        *remainder = 0;
+        return -MOUSEKEY_MOVE_MAX;
+    }
+    *remainder = total - counts * 256;
+    return counts;
+}
+
+static bool is_moving(void)
+{
+    return move_x || move_y || wheel_v || wheel_h || kinetic_speed;
 }
 
 void mousekey_task(void)
 {
-    if (timer_elapsed(last_timer) < (mousekey_repeat ? mk_interval : mk_delay*10))
+    if (!is_moving())
         return;
 
-    if (mouse_report.x == 0 && mouse_report.y == 0 && mouse_report.v == 0 && mouse_report.h == 0)
+    uint16_t elapsed = timer_elapsed(last_timer);
+    if (elapsed < (mousekey_repeat ? interval() : mk_delay*10))
         return;
 
-    if (mousekey_repeat != UINT8_MAX)
-        mousekey_repeat++;
+    if (mousekey_repeat) {
+        mousekey_time = (mousekey_time > UINT16_MAX - elapsed) ? UINT16_MAX : mousekey_time + elapsed;
+    } else {
+        // the delay only holds the first repeat back, motion starts from now
+        mousekey_repeat = true;
+        elapsed = interval();
+    }
 
+    int8_t x = move_x, y = move_y;
+    uint16_t distance = travel(move_speed(elapsed), elapsed);
+    if (!x && !y) {
+        // kinetic curve coasting to a halt
+        x = coast_x;
+        y = coast_y;
+    }
+    /* diagonal move [1/sqrt(2) = 181/256] */
+    if (x && y) {
+        distance = ((uint32_t)distance * 181) >> 8;
+    }
+    mouse_report.x = advance(&rem_x, x, distance);
+    mouse_report.y = advance(&rem_y, y, distance);
 
-    if (mouse_report.x > 0) mouse_report.x = move_unit();
-    if (mouse_report.x < 0) mouse_report.x = move_unit() * -1;
-    if (mouse_report.y > 0) mouse_report.y = move_unit();
-    if (mouse_report.y < 0) mouse_report.y = move_unit() * -1;
+    distance = travel(wheel_speed(), elapsed);
+    mouse_report.v = advance(&rem_v, wheel_v, distance);
+    mouse_report.h = advance(&rem_h, wheel_h, distance);
 
-    /* diagonal move [1/sqrt(2) = 0.7] */
-    if (mouse_report.x && mouse_report.y) {
-        mouse_report.x *= 0.7;
-        mouse_report.y *= 0.7;
+    if (mouse_report.x || mouse_report.y || mouse_report.v || mouse_report.h) {
+        mousekey_send();
+    } else {
+        last_timer = timer_read();
     }
+}
 
-    if (mouse_report.v > 0) mouse_report.v = wheel_unit();
-    if (mouse_report.v < 0) mouse_report.v = wheel_unit() * -1;
-    if (mouse_report.h > 0) mouse_report.h = wheel_unit();
-    if (mouse_report.h < 0) mouse_report.h = wheel_unit() * -1;
-
-    mousekey_send();
+static int8_t start_unit(uint8_t delta, uint8_t max, uint8_t time_to_max)
+{
+    if (!mousekey_accel) {
+        return delta;
+    }
+    uint16_t unit = ((uint32_t)ramp_speed(max_speed(delta, max), time_to_max, MOUSEKEY_CURVE_LINEAR) * interval()) >> 8;
+    return unit > MOUSEKEY_MOVE_MAX ? MOUSEKEY_MOVE_MAX : (unit == 0 ? 1 : unit);
 }
 
 void mousekey_on(uint8_t code)
 {
-    if      (code == KC_MS_UP)       mouse_report.y = move_unit() * -1;
-    else if (code == KC_MS_DOWN)     mouse_report.y = move_unit();
-    else if (code == KC_MS_LEFT)     mouse_report.x = move_unit() * -1;
-    else if (code == KC_MS_RIGHT)    mouse_report.x = move_unit();
-    else if (code == KC_MS_WH_UP)    mouse_report.v = wheel_unit();
-    else if (code == KC_MS_WH_DOWN)  mouse_report.v = wheel_unit() * -1;
-    else if (code == KC_MS_WH_LEFT)  mouse_report.h = wheel_unit() * -1;
-    else if (code == KC_MS_WH_RIGHT) mouse_report.h = wheel_unit();
+    if (!is_moving()) {
+        mousekey_repeat = false;
+        mousekey_time = 0;
+    }
+
+    if      (code == KC_MS_UP)       move_y = -1;
+    else if (code == KC_MS_DOWN)     move_y = 1;
+    else if (code == KC_MS_LEFT)     move_x = -1;
+    else if (code == KC_MS_RIGHT)    move_x = 1;
+    else if (code == KC_MS_WH_UP)    wheel_v = 1;
+    else if (code == KC_MS_WH_DOWN)  wheel_v = -1;
+    else if (code == KC_MS_WH_LEFT)  wheel_h = -1;
+    else if (code == KC_MS_WH_RIGHT) wheel_h = 1;
     else if (code == KC_MS_BTN1)     mouse_report.buttons |= MOUSE_BTN1;
     else if (code == KC_MS_BTN2)     mouse_report.buttons |= MOUSE_BTN2;
     else if (code == KC_MS_BTN3)     mouse_report.buttons |= MOUSE_BTN3;
@@ -143,18 +250,31 @@ void mousekey_on(uint8_t code)
     else if (code == KC_MS_ACCEL0)   mousekey_accel |= (1<<0);
     else if (code == KC_MS_ACCEL1)   mousekey_accel |= (1<<1);
     else if (code == KC_MS_ACCEL2)   mousekey_accel |= (1<<2);
+
+    // the press itself moves one step, the repeat starts after mk_delay
+    if (IS_MOUSEKEY_MOVE(code)) {
+        coast_x = move_x;
+        coast_y = move_y;
+        int8_t unit = start_unit(MOUSEKEY_MOVE_DELTA, mk_max_speed, mk_time_to_max);
+        if (code == KC_MS_UP || code == KC_MS_DOWN) mouse_report.y = move_y * unit;
+        else                                        mouse_report.x = move_x * unit;
+    } else if (IS_MOUSEKEY_WHEEL(code)) {
+        int8_t unit = start_unit(MOUSEKEY_WHEEL_DELTA, mk_wheel_max_speed, mk_wheel_time_to_max);
+        if (code == KC_MS_WH_UP || code == KC_MS_WH_DOWN) mouse_report.v = wheel_v * unit;
+        else                                              mouse_report.h = wheel_h * unit;
+    }
 }
 
 void mousekey_off(uint8_t code)
 {
-    if      (code == KC_MS_UP       && mouse_report.y < 0) mouse_report.y = 0;
-    else if (code == KC_MS_DOWN     && mouse_report.y > 0) mouse_report.y = 0;
-    else if (code == KC_MS_LEFT     && mouse_report.x < 0) mouse_report.x = 0;
-    else if (code == KC_MS_RIGHT    && mouse_report.x > 0) mouse_report.x = 0;
-    else if (code == KC_MS_WH_UP    && mouse_report.v > 0) mouse_report.v = 0;
-    else if (code == KC_MS_WH_DOWN  && mouse_report.v < 0) mouse_report.v = 0;
-    else if (code == KC_MS_WH_LEFT  && mouse_report.h < 0) mouse_report.h = 0;
-    else if (code == KC_MS_WH_RIGHT && mouse_report.h > 0) mouse_report.h = 0;
+    if      (code == KC_MS_UP       && move_y < 0) move_y = 0;
+    else if (code == KC_MS_DOWN     && move_y > 0) move_y = 0;
+    else if (code == KC_MS_LEFT     && move_x < 0) move_x = 0;
+    else if (code == KC_MS_RIGHT    && move_x > 0) move_x = 0;
+    else if (code == KC_MS_WH_UP    && wheel_v > 0) wheel_v = 0;
+    else if (code == KC_MS_WH_DOWN  && wheel_v < 0) wheel_v = 0;
+    else if (code == KC_MS_WH_LEFT  && wheel_h < 0) wheel_h = 0;
+    else if (code == KC_MS_WH_RIGHT && wheel_h > 0) wheel_h = 0;
     else if (code == KC_MS_BTN1) mouse_report.buttons &= ~MOUSE_BTN1;
     else if (code == KC_MS_BTN2) mouse_report.buttons &= ~MOUSE_BTN2;
     else if (code == KC_MS_BTN3) mouse_report.buttons &= ~MOUSE_BTN3;
@@ -164,8 +284,13 @@ void mousekey_off(uint8_t code)
     else if (code == KC_MS_ACCEL1) mousekey_accel &= ~(1<<1);
     else if (code == KC_MS_ACCEL2) mousekey_accel &= ~(1<<2);
 
-    if (mouse_report.x == 0 && mouse_report.y == 0 && mouse_report.v == 0 && mouse_report.h == 0)
-        mousekey_repeat = 0;
+    if (move_x || move_y) {
+        coast_x = move_x;
+        coast_y = move_y;
+    }
+    if (mk_curve != MOUSEKEY_CURVE_KINETIC || !mousekey_repeat) {
+        kinetic_speed = 0;
+    }
 }
 
 void mousekey_send(void)
@@ -173,12 +298,18 @@ void mousekey_send(void)
     mousekey_debug();
     host_mouse_send(&mouse_report);
     last_timer = timer_read();
+    // motion is reported once, buttons stay down
+    mouse_report.x = mouse_report.y = mouse_report.v = mouse_report.h = 0;
 }
 
 void mousekey_clear(void)
 {
     mouse_report = (report_mouse_t){};
-    mousekey_repeat = 0;
+    move_x = move_y = wheel_v = wheel_h = 0;
+    rem_x = rem_y = rem_v = rem_h = 0;
+    kinetic_speed = 0;
+    mousekey_repeat = false;
+    mousekey_time = 0;
     mousekey_accel = 0;
 }
 
@@ -191,6 +322,6 @@ static void mousekey_debug(void)
     print_decs(mouse_report.y); print(" ");
     print_decs(mouse_report.v); print(" ");
     print_decs(mouse_report.h); print("](");
-    print_dec(mousekey_repeat); print("/");
+    print_dec(mousekey_time); print("/");
     print_dec(mousekey_accel); print(")\n");
 }
@@ -51,6 +51,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MOUSEKEY_WHEEL_TIME_TO_MAX 40
 #endif
 
+/* how the pointer speeds up over MOUSEKEY_TIME_TO_MAX intervals */
+#define MOUSEKEY_CURVE_LINEAR       0
+#define MOUSEKEY_CURVE_QUADRATIC    1
+/* eases in and keeps gliding for a moment after the keys are released */
+#define MOUSEKEY_CURVE_KINETIC      2
+#ifndef MOUSEKEY_CURVE
+#define MOUSEKEY_CURVE MOUSEKEY_CURVE_LINEAR
+#endif
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -60,6 +69,7 @@ extern uint8_t mk_delay;
 extern uint8_t mk_interval;
 extern uint8_t mk_max_speed;
 extern uint8_t mk_time_to_max;
+extern uint8_t mk_curve;
 extern uint8_t mk_wheel_max_speed;
 extern uint8_t mk_wheel_time_to_max;
 
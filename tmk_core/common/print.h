@@ -39,6 +39,9 @@
 #if defined(__AVR__) /* __AVR__ */
 
 #  include "avr/xprintf.h"
+#  ifdef BINARY_LOG_ENABLE
+#    include "avr/binlog.h"
+#  endif
 
 #  ifdef USER_PRINT /* USER_PRINT */
 
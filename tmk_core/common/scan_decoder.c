@@ -0,0 +1,146 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "scan_decoder.h"
+#include "action.h"
+#include "timer.h"
+#include "progmem.h"
+#include "debug.h"
+
+#if (MATRIX_ROW_WORDS > 1)
+#   error "scan_decoder: MATRIX_COLS must be 32 or less"
+#endif
+
+
+static const scan_decoder_t *decoder;
+static uint8_t state = 0;
+static bool released = false;
+static bool clearing = false;
+static matrix_row_t matrix[MATRIX_ROWS];
+
+/* Written by the interrupt only at head and read by keyboard_task only at
+ * tail, byte sized indexes need no locking. */
+static uint8_t fifo[SCAN_DECODER_FIFO_SIZE];
+static volatile uint8_t fifo_head = 0;
+static volatile uint8_t fifo_tail = 0;
+
+
+void scan_decoder_init(const scan_decoder_t *d)
+{
+    decoder = d;
+    state = 0;
+    released = false;
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) matrix[r] = 0;
+}
+
+void scan_decoder_put(uint8_t code)
+{
+    uint8_t next = (fifo_head + 1) % SCAN_DECODER_FIFO_SIZE;
+    if (next != fifo_tail) {
+        fifo[fifo_head] = code;
+        fifo_head = next;
+    }
+}
+
+void scan_decoder_clear(void)
+{
+    fifo_tail = fifo_head;
+    state = 0;
+    released = false;
+    clearing = true;
+}
+
+matrix_row_t scan_decoder_get_row(uint8_t row)
+{
+    return matrix[row];
+}
+
+static bool send_key(uint8_t key, bool pressed)
+{
+    uint8_t row = key / MATRIX_COLS;
+    uint8_t col = key % MATRIX_COLS;
+    matrix_row_t bit = (matrix_row_t)1<<col;
+
+    // typematic repeats and releases of keys that aren't down
+    if (!(matrix[row] & bit) == !pressed)
+        return false;
+
+    matrix[row] ^= bit;
+    action_exec((keyevent_t){
+        .key = (keypos_t){ .row = row, .col = col },
+        .pressed = pressed,
+        .time = (timer_read() | 1) /* time should not be 0 */
+    });
+    return true;
+}
+
+/* releases one of the keys left down by scan_decoder_clear() */
+static bool release_one(void)
+{
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        if (!matrix[r])
+            continue;
+        for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+            if (matrix[r] & ((matrix_row_t)1<<c))
+                return send_key(r * MATRIX_COLS + c, false);
+        }
+    }
+    clearing = false;
+    return false;
+}
+
+static bool decode(uint8_t code)
+{
+    for (uint8_t i = 0; i < decoder->prefix_count; i++) {
+        if (pgm_read_byte(&decoder->prefixes[i].state) == state &&
+            pgm_read_byte(&decoder->prefixes[i].code) == code) {
+            uint8_t next = pgm_read_byte(&decoder->prefixes[i].next);
+            state = SCAN_STATE(next);
+            released |= (next & SCAN_BREAK);
+            return false;
+        }
+    }
+
+    bool pressed = !released;
+    if (code & decoder->break_mask) {
+        pressed = false;
+        code &= ~decoder->break_mask;
+    }
+
+    uint8_t key = SCAN_NO_KEY;
+    uint8_t i;
+    for (i = 0; i < decoder->remap_count; i++) {
+        if (pgm_read_byte(&decoder->remaps[i].state) == state &&
+            pgm_read_byte(&decoder->remaps[i].code) == code) {
+            key = pgm_read_byte(&decoder->remaps[i].key);
+            break;
+        }
+    }
+    if (i == decoder->remap_count) {
+        if (state == 0 && code < decoder->key_count) {
+            key = code;
+        } else {
+            debug("scan_decoder: unexpected "); debug_hex(state); debug(":"); debug_hex(code); debug("\n");
+        }
+    }
+
+    state = 0;
+    released = false;
+    if (key == SCAN_NO_KEY)
+        return false;
+    return send_key(key, pressed);
+}
+
+bool scan_decoder_task(void)
+{
+    if (clearing && release_one())
+        return true;
+
+    while (fifo_tail != fifo_head) {
+        uint8_t code = fifo[fifo_tail];
+        fifo_tail = (fifo_tail + 1) % SCAN_DECODER_FIFO_SIZE;
+        // process a key per task call
+        if (decode(code))
+            return true;
+    }
+    return false;
+}
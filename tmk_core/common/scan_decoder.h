@@ -0,0 +1,69 @@
+#ifndef SCAN_DECODER_H
+#define SCAN_DECODER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+/*
+ * Scan code decoder for protocol converters
+ *
+ * The protocol's receive interrupt puts scan code bytes with
+ * scan_decoder_put() and keyboard_task decodes them with two PROGMEM
+ * tables, so a converter describes its code set instead of coding a state
+ * machine:
+ *
+ *   prefixes  a byte received in a state that moves to another state and
+ *             may mark the code as a release, e.g. {0, 0xF0, SCAN_BREAK}
+ *   remaps    the key of a code received in a state, e.g. {1, 0x11, 0x85}
+ *             for E0 11. In state 0 a code without remap is its own key.
+ *
+ * A key is row * MATRIX_COLS + col. The decoded events go straight to
+ * action_exec(), keyboard_task doesn't diff a virtual matrix. The decoder
+ * still keeps the state of the keys, scan_decoder_get_row() returns it for
+ * matrix_get_row().
+ */
+
+/* next state of a prefix */
+#define SCAN_STATE(n)   ((n) & 0x7F)
+#define SCAN_BREAK      0x80
+
+/* key of a remap whose code is dropped, like the fake shifts of set 2 */
+#define SCAN_NO_KEY     0xFF
+
+#ifndef SCAN_DECODER_FIFO_SIZE
+#define SCAN_DECODER_FIFO_SIZE  16
+#endif
+
+typedef struct {
+    uint8_t state;
+    uint8_t code;
+    uint8_t next;
+} scan_prefix_t;
+
+typedef struct {
+    uint8_t state;
+    uint8_t code;
+    uint8_t key;
+} scan_remap_t;
+
+typedef struct {
+    const scan_prefix_t *prefixes;
+    const scan_remap_t *remaps;
+    uint8_t prefix_count;
+    uint8_t remap_count;
+    uint8_t break_mask;     /* bit of a code that marks a release, 0 if none */
+    uint8_t key_count;      /* codes from this up are unexpected in state 0 */
+} scan_decoder_t;
+
+void scan_decoder_init(const scan_decoder_t *decoder);
+/* called from the receive interrupt, other callers disable interrupts
+ * around it */
+void scan_decoder_put(uint8_t code);
+/* releases every key, e.g. after the keyboard was reset */
+void scan_decoder_clear(void);
+/* decodes until an event is sent, returns false when there was none */
+bool scan_decoder_task(void);
+matrix_row_t scan_decoder_get_row(uint8_t row);
+
+#endif
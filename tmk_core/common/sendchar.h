@@ -27,6 +27,8 @@ extern "C" {
 
 /* transmit a character.  return 0 on success, -1 on error. */
 int8_t sendchar(uint8_t c);
+/* bytes sendchar() takes without waiting, 0xFF if the driver can't tell */
+uint8_t sendchar_room(void);
 
 #ifdef __cplusplus
 }
@@ -50,5 +50,15 @@ ifdef ADB_MOUSE_ENABLE
 	 OPT_DEFS += -DADB_MOUSE_ENABLE -DMOUSE_ENABLE
 endif
 
+ifdef ADB_USE_BUSYWAIT
+    SRC += protocol/adb.c
+    OPT_DEFS += -DADB_USE_BUSYWAIT
+endif
+
+ifdef ADB_USE_INT
+    SRC += protocol/adb_interrupt.c
+    OPT_DEFS += -DADB_USE_INT
+endif
+
 # Search Path
 VPATH += $(TMK_DIR)/protocol
@@ -53,6 +53,9 @@ POSSIBILITY OF SUCH DAMAGE.
 
 
 // ADB host
+// adb.c talks to the bus with interrupts disabled, call the recv functions
+// about every 12ms. adb_interrupt.c polls the devices in the background and
+// its recv functions return 0 until something new has arrived.
 void     adb_host_init(void);
 bool     adb_host_psw(void);
 uint16_t adb_host_kbd_recv(void);
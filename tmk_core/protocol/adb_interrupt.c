@@ -0,0 +1,353 @@
+/*
+Copyright 2011 Jun WAKO <wakojun@gmail.com>
+Copyright 2013 Shay Green <gblargg@gmail.com>
+
+This software is licensed with a Modified BSD License.
+All of this is supposed to be Free Software, Open Source, DFSG-free,
+GPL-compatible, and OK to use in both free and proprietary applications.
+Additions and corrections to this file are welcome.
+
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in
+  the documentation and/or other materials provided with the
+  distribution.
+
+* Neither the name of the copyright holders nor the names of
+  contributors may be used to endorse or promote products derived
+  from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * ADB host, interrupt version
+ *
+ * Drop-in replacement for adb.c that runs the bus from interrupts instead
+ * of busy waiting with interrupts disabled. A converter picks it with
+ * ADB_USE_INT = yes in its rules.mk, and adb.c with ADB_USE_BUSYWAIT = yes. Timer1 compare A places the
+ * attention signal and the bit cells of the commands, and a pin interrupt
+ * on the data line timestamps the edges of the device's answer with TCNT1.
+ * Once started the host polls the keyboard, and the mouse with
+ * ADB_MOUSE_ENABLE, on its own every ADB_POLL_INTERVAL ms. The recv
+ * functions only pick up what was received and never block.
+ *
+ * Needs in config.h, besides the ADB_PORT settings:
+ *   ADB_INT_INIT()  set the data line interrupt to trigger on any edge
+ *   ADB_INT_ON()    clear its pending flag and enable it
+ *   ADB_INT_OFF()   disable it
+ *   ADB_INT_VECT    its vector
+ * Timer1 must not be used for anything else.
+ */
+
+#include <stdbool.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "adb.h"
+
+#if !(defined(ADB_INT_INIT) && defined(ADB_INT_ON) && defined(ADB_INT_OFF) && defined(ADB_INT_VECT))
+#   error "ADB interrupt setting is required in config.h"
+#endif
+
+
+#define data_lo() (ADB_DDR |=  (1<<ADB_DATA_BIT))
+#define data_hi() (ADB_DDR &= ~(1<<ADB_DATA_BIT))
+#define data_in() (ADB_PIN &   (1<<ADB_DATA_BIT))
+
+/* Timer1 runs at F_CPU/8 */
+#define US(us)  ((uint16_t)((uint32_t)(us) * (F_CPU / 8000) / 1000))
+
+#ifndef ADB_POLL_INTERVAL
+#define ADB_POLL_INTERVAL   12  // ms between two polls of a device
+#endif
+
+#ifdef ADB_MOUSE_ENABLE
+#   define ADB_POLL_GAP     (ADB_POLL_INTERVAL * 1000 / 2)
+#else
+#   define ADB_POLL_GAP     (ADB_POLL_INTERVAL * 1000)
+#endif
+
+enum {
+    ADDR_KEYB  = 0x20,
+    ADDR_MOUSE = 0x30
+};
+
+static enum {
+    GAP,            // bus idle until the next poll
+    TALK_COMMAND,   // attention, start bit, command and stop bit
+    TALK,           // waiting for and receiving the device's answer
+    LISTEN_COMMAND,
+    LISTEN_DATA,    // Tlt, start bit, data and stop bit
+} state = GAP;
+
+/* bit cells to send, most significant first */
+static uint32_t tx_cells;
+static uint8_t tx_count;
+static bool tx_high;
+
+static uint8_t device;
+static uint8_t rx_falls;
+static uint16_t rx_fall_time;
+static uint16_t rx_low;
+static uint16_t rx_data;
+
+static volatile bool listen_pending = false;
+static uint8_t listen_cmd;
+static uint16_t listen_data;
+
+
+/*--------------------------------------------------------------------
+ * Ring buffers of received register 0 data
+ *------------------------------------------------------------------*/
+#define RBUF_SIZE 4
+typedef struct {
+    uint16_t data[RBUF_SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+} rbuf_t;
+
+static rbuf_t kbd_rbuf;
+#ifdef ADB_MOUSE_ENABLE
+static rbuf_t mouse_rbuf;
+#endif
+
+static void rbuf_enqueue(rbuf_t *rbuf, uint16_t data)
+{
+    uint8_t next = (rbuf->head + 1) % RBUF_SIZE;
+    if (next != rbuf->tail) {
+        rbuf->data[rbuf->head] = data;
+        rbuf->head = next;
+    }
+}
+
+static uint16_t rbuf_dequeue(rbuf_t *rbuf)
+{
+    uint16_t data = 0;
+    uint8_t sreg = SREG;
+    cli();
+    if (rbuf->head != rbuf->tail) {
+        data = rbuf->data[rbuf->tail];
+        rbuf->tail = (rbuf->tail + 1) % RBUF_SIZE;
+    }
+    SREG = sreg;
+    return data;
+}
+
+
+void adb_host_init(void)
+{
+    ADB_PORT &= ~(1<<ADB_DATA_BIT);
+    data_hi();
+#ifdef ADB_PSW_BIT
+    ADB_PORT |=  (1<<ADB_PSW_BIT);
+    ADB_DDR  &= ~(1<<ADB_PSW_BIT);
+#endif
+
+    ADB_INT_INIT();
+    ADB_INT_OFF();
+
+    state = GAP;
+    TCCR1A = 0;
+    TCCR1B = (1<<CS11);
+    OCR1A = TCNT1 + US(ADB_POLL_GAP);
+    TIFR1 = (1<<OCF1A);
+    TIMSK1 |= (1<<OCIE1A);
+}
+
+#ifdef ADB_PSW_BIT
+bool adb_host_psw(void)
+{
+    return ADB_PIN & (1<<ADB_PSW_BIT);
+}
+#endif
+
+uint16_t adb_host_kbd_recv(void)
+{
+    return rbuf_dequeue(&kbd_rbuf);
+}
+
+#ifdef ADB_MOUSE_ENABLE
+void adb_mouse_init(void) {
+	    return;
+}
+
+uint16_t adb_host_mouse_recv(void)
+{
+    return rbuf_dequeue(&mouse_rbuf);
+}
+#endif
+
+/* Sent in place of the next poll */
+void adb_host_listen(uint8_t cmd, uint8_t data_h, uint8_t data_l)
+{
+    uint8_t sreg = SREG;
+    cli();
+    listen_cmd = cmd;
+    listen_data = (data_h << 8) | data_l;
+    listen_pending = true;
+    SREG = sreg;
+}
+
+// send state of LEDs
+void adb_host_kbd_led(uint8_t led)
+{
+    // Addr:Keyboard(0010), Cmd:Listen(10), Register2(10)
+    // send upper byte (not used)
+    // send lower byte (bit2: ScrollLock, bit1: CapsLock, bit0:
+    adb_host_listen(0x2A,0,led&0x07);
+}
+
+
+static void start_command(void)
+{
+    uint8_t cmd;
+    if (listen_pending) {
+        listen_pending = false;
+        cmd = listen_cmd;
+    } else {
+#ifdef ADB_MOUSE_ENABLE
+        device = (device == ADDR_KEYB) ? ADDR_MOUSE : ADDR_KEYB;
+#else
+        device = ADDR_KEYB;
+#endif
+        cmd = device | 0x0C;    // Cmd:Talk(11), Register0(00)
+    }
+    // Startbit(1), command, Stopbit(0)
+    tx_cells = ((uint32_t)1 << 9) | ((uint16_t)cmd << 1);
+    tx_count = 10;
+    tx_high = false;
+    state = (cmd & 0x0C) == 0x08 ? LISTEN_COMMAND : TALK_COMMAND;
+
+    // Attention, the start bit keeps the line low for 35us more
+    data_lo();
+    OCR1A += US(800 - 35);
+}
+
+static void finish(void)
+{
+    ADB_INT_OFF();
+    data_hi();
+    state = GAP;
+    OCR1A = TCNT1 + US(ADB_POLL_GAP);
+}
+
+static void talk_received(uint16_t data)
+{
+#ifdef ADB_MOUSE_ENABLE
+    if (device == ADDR_MOUSE) {
+        rbuf_enqueue(&mouse_rbuf, data);
+        return;
+    }
+#endif
+    rbuf_enqueue(&kbd_rbuf, data);
+}
+
+ISR(TIMER1_COMPA_vect)
+{
+    if (state == GAP) {
+        start_command();
+        return;
+    }
+    if (state == TALK) {
+        // no start bit within Tlt means no data, anything later is broken
+        finish();
+        return;
+    }
+
+    if (tx_high) {
+        // high part of the bit cell
+        bool bit = tx_cells & ((uint32_t)1 << (tx_count - 1));
+        data_hi();
+        OCR1A += bit ? US(65) : US(35);
+        tx_high = false;
+        tx_count--;
+        return;
+    }
+
+    if (tx_count == 0) {
+        if (state == LISTEN_COMMAND) {
+            // Tlt(140-260us), then Startbit(1), data, Stopbit(0)
+            tx_cells = ((uint32_t)1 << 17) | ((uint32_t)listen_data << 1);
+            tx_count = 18;
+            state = LISTEN_DATA;
+            OCR1A += US(200);
+        } else if (state == LISTEN_DATA) {
+            finish();
+        } else {
+            // The device answers after Tlt, or holds the stop bit low a
+            // little longer for a service request, which is ignored
+            state = TALK;
+            rx_falls = 0;
+            rx_data = 0;
+            ADB_INT_ON();
+            OCR1A = TCNT1 + US(500);
+        }
+        return;
+    }
+
+    // low part of the bit cell
+    bool bit = tx_cells & ((uint32_t)1 << (tx_count - 1));
+    data_lo();
+    OCR1A += bit ? US(35) : US(65);
+    tx_high = true;
+}
+
+/*
+ * Each bit of the answer is decoded at the falling edge that starts the
+ * next one: it's a 1 when the line was low for a shorter time than high.
+ * The start bit ends at the second falling edge and the stop bit starts at
+ * the 18th, which completes the 16 data bits.
+ */
+ISR(ADB_INT_VECT)
+{
+    uint16_t now = TCNT1;
+
+    if (state != TALK)
+        return;
+
+    // Tlt is at most 260us and a bit cell at most 130us
+    OCR1A = now + US(300);
+
+    if (data_in()) {
+        if (rx_falls) {
+            rx_low = now - rx_fall_time;
+        }
+        return;
+    }
+
+    if (rx_falls) {
+        uint16_t high = now - rx_fall_time - rx_low;
+        bool bit = rx_low < high;
+        if (rx_falls == 1 && !bit) {
+            // start bit must be 1
+            finish();
+            return;
+        }
+        if (rx_falls > 1) {
+            rx_data = (rx_data << 1) | bit;
+        }
+    }
+    rx_falls++;
+    rx_fall_time = now;
+
+    if (rx_falls == 18) {
+        talk_received(rx_data);
+        finish();
+    }
+}
@@ -829,6 +829,21 @@ ERROR_EXIT:
     Endpoint_SelectEndpoint(ep);
     return -1;
 }
+
+uint8_t sendchar_room(void)
+{
+    if (USB_DeviceState != DEVICE_STATE_Configured)
+        return 0;
+
+    uint8_t room = 0;
+    uint8_t ep = Endpoint_GetCurrentEndpoint();
+    Endpoint_SelectEndpoint(CONSOLE_IN_EPNUM);
+    // the bank is free until it is handed to the host
+    if (Endpoint_IsEnabled() && Endpoint_IsConfigured() && Endpoint_IsReadWriteAllowed())
+        room = CONSOLE_EPSIZE - Endpoint_BytesInEndpoint();
+    Endpoint_SelectEndpoint(ep);
+    return room;
+}
 #else
 int8_t sendchar(uint8_t c)
 {
@@ -92,6 +92,11 @@ uint8_t ps2_host_recv_response(void);
 uint8_t ps2_host_recv(void);
 void ps2_host_set_led(uint8_t usb_led);
 
+/* Called from the receive interrupt with every byte, or with error set when
+ * a frame was broken. Return true when the byte was taken care of and
+ * shouldn't be queued for ps2_host_recv(). */
+bool ps2_host_recv_hook(uint8_t data, uint8_t error);
+
 
 /*--------------------------------------------------------------------
  * static functions
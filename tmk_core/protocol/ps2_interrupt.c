@@ -139,6 +139,12 @@ uint8_t ps2_host_recv_response(void)
     return pbuf_dequeue();
 }
 
+__attribute__ ((weak))
+bool ps2_host_recv_hook(uint8_t data, uint8_t error)
+{
+    return false;
+}
+
 /* get data received by interrupt */
 uint8_t ps2_host_recv(void)
 {
@@ -202,7 +208,8 @@ ISR(PS2_INT_VECT)
         case STOP:
             if (!data_in())
                 goto ERROR;
-            pbuf_enqueue(data);
+            if (!ps2_host_recv_hook(data, PS2_ERR_NONE))
+                pbuf_enqueue(data);
             goto DONE;
             break;
         default:
@@ -211,6 +218,7 @@ ISR(PS2_INT_VECT)
     goto RETURN;
 ERROR:
     ps2_error = state;
+    ps2_host_recv_hook(0, state);
 DONE:
     state = INIT;
     data = 0;
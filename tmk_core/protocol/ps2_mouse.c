@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdbool.h>
 #include<avr/io.h>
+#include<avr/interrupt.h>
 #include<util/delay.h>
 #include "ps2_mouse.h"
 #include "host.h"
@@ -30,11 +31,29 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 static report_mouse_t mouse_report = {};
 
+#ifdef PS2_MOUSE_STREAM
+typedef struct {
+    uint8_t buttons;
+    int16_t x;
+    int16_t y;
+    int16_t v;
+} ps2_mouse_packet_t;
+
+static ps2_mouse_packet_t packets[PS2_MOUSE_PACKET_QUEUE];
+static volatile uint8_t packets_head = 0;
+static volatile uint8_t packets_tail = 0;
+static volatile bool streaming = false;
+static uint8_t packet[PS2_MOUSE_PACKET_SIZE];
+static uint8_t packet_index = 0;
+static uint16_t packet_time = 0;
+#endif
+
 static inline void ps2_mouse_print_report(report_mouse_t *mouse_report);
 static inline void ps2_mouse_convert_report_to_hid(report_mouse_t *mouse_report);
 static inline void ps2_mouse_clear_report(report_mouse_t *mouse_report);
 static inline void ps2_mouse_enable_scrolling(void);
 static inline void ps2_mouse_scroll_button_task(report_mouse_t *mouse_report);
+static void ps2_mouse_send_report(report_mouse_t *mouse_report);
 
 /* ============================= IMPLEMENTATION ============================ */
 
@@ -51,8 +70,6 @@ void ps2_mouse_init(void) {
 
 #ifdef PS2_MOUSE_USE_REMOTE_MODE
     ps2_mouse_set_remote_mode();
-#else
-    ps2_mouse_enable_data_reporting();
 #endif
 
 #ifdef PS2_MOUSE_ENABLE_SCROLLING
@@ -63,13 +80,118 @@ void ps2_mouse_init(void) {
     ps2_mouse_set_scaling_2_1();
 #endif
 
+    // may send its own commands and read their answers
     ps2_mouse_init_user();
+
+#ifndef PS2_MOUSE_USE_REMOTE_MODE
+    // last, so the answers to the commands above aren't taken for packets
+    ps2_mouse_enable_data_reporting();
+#endif
 }
 
 __attribute__((weak))
 void ps2_mouse_init_user(void) {
 }
 
+#ifdef PS2_MOUSE_STREAM
+static int16_t ps2_mouse_delta(uint8_t data, uint8_t status, uint8_t sign, uint8_t overflow) {
+    if (status & (1<<overflow)) {
+        return (status & (1<<sign)) ? -256 : 255;
+    }
+    return (status & (1<<sign)) ? (int16_t)data - 256 : data;
+}
+
+static int16_t ps2_mouse_add(int16_t a, int16_t b) {
+    int32_t sum = (int32_t)a + b;
+    return sum > INT16_MAX ? INT16_MAX : (sum < INT16_MIN ? INT16_MIN : sum);
+}
+
+/* Runs in the receive interrupt: puts packets together and queues them */
+bool ps2_host_recv_hook(uint8_t data, uint8_t error) {
+    if (!streaming) {
+        return false;
+    }
+    if (error) {
+        // the rest of this packet can't be trusted
+        packet_index = 0;
+        return true;
+    }
+
+    uint16_t now = timer_read();
+    if (packet_index && TIMER_DIFF_16(now, packet_time) > PS2_MOUSE_PACKET_TIMEOUT) {
+        packet_index = 0;
+    }
+    packet_time = now;
+    // bit 3 of the first byte is always set, anything else is out of step
+    if (packet_index == 0 && !(data & 0x08)) {
+        return true;
+    }
+    packet[packet_index++] = data;
+    if (packet_index < PS2_MOUSE_PACKET_SIZE) {
+        return true;
+    }
+    packet_index = 0;
+
+    uint8_t buttons = packet[0] & PS2_MOUSE_BTN_MASK;
+    int16_t x = ps2_mouse_delta(packet[1], packet[0], PS2_MOUSE_X_SIGN, PS2_MOUSE_X_OVFLW);
+    int16_t y = ps2_mouse_delta(packet[2], packet[0], PS2_MOUSE_Y_SIGN, PS2_MOUSE_Y_OVFLW);
+#ifdef PS2_MOUSE_ENABLE_SCROLLING
+    int16_t v = (int8_t)(packet[3] & PS2_MOUSE_SCROLL_MASK);
+#else
+    int16_t v = 0;
+#endif
+
+    ps2_mouse_packet_t *last = &packets[(packets_head + PS2_MOUSE_PACKET_QUEUE - 1) % PS2_MOUSE_PACKET_QUEUE];
+    if (packets_head != packets_tail && last->buttons == buttons) {
+        last->x = ps2_mouse_add(last->x, x);
+        last->y = ps2_mouse_add(last->y, y);
+        last->v = ps2_mouse_add(last->v, v);
+        return true;
+    }
+    uint8_t next = (packets_head + 1) % PS2_MOUSE_PACKET_QUEUE;
+    if (next != packets_tail) {
+        packets[packets_head] = (ps2_mouse_packet_t){ .buttons = buttons, .x = x, .y = y, .v = v };
+        packets_head = next;
+    }
+    return true;
+}
+
+static int8_t ps2_mouse_take(int16_t *delta) {
+    int16_t value = *delta > 127 ? 127 : (*delta < -127 ? -127 : *delta);
+    *delta -= value;
+    return value;
+}
+
+void ps2_mouse_task(void) {
+    uint8_t sreg = SREG;
+    cli();
+    if (packets_head == packets_tail) {
+        SREG = sreg;
+        return;
+    }
+    // sends at most 127 counts per report, the rest stays queued
+    ps2_mouse_packet_t *p = &packets[packets_tail];
+    mouse_report.buttons = p->buttons;
+    mouse_report.x = ps2_mouse_take(&p->x);
+    mouse_report.y = ps2_mouse_take(&p->y);
+    mouse_report.v = ps2_mouse_take(&p->v);
+    if (!p->x && !p->y && !p->v) {
+        packets_tail = (packets_tail + 1) % PS2_MOUSE_PACKET_QUEUE;
+    }
+    SREG = sreg;
+
+#ifdef PS2_MOUSE_DEBUG_RAW
+    ps2_mouse_print_report(&mouse_report);
+#endif
+    mouse_report.x *= PS2_MOUSE_X_MULTIPLIER;
+    mouse_report.y *= -PS2_MOUSE_Y_MULTIPLIER;
+    mouse_report.v *= -PS2_MOUSE_V_MULTIPLIER;
+    ps2_mouse_send_report(&mouse_report);
+    ps2_mouse_clear_report(&mouse_report);
+}
+
+#else
+
 void ps2_mouse_task(void) {
     static uint8_t buttons_prev = 0;
 
@@ -97,25 +219,39 @@ void ps2_mouse_task(void) {
 #endif
         buttons_prev = mouse_report.buttons;
         ps2_mouse_convert_report_to_hid(&mouse_report);
+        ps2_mouse_send_report(&mouse_report);
+    }
+    
+    ps2_mouse_clear_report(&mouse_report);
+}
+
+#endif
+
+static void ps2_mouse_send_report(report_mouse_t *mouse_report) {
 #if PS2_MOUSE_SCROLL_BTN_MASK
-        ps2_mouse_scroll_button_task(&mouse_report);
+    ps2_mouse_scroll_button_task(mouse_report);
 #endif
 #ifdef PS2_MOUSE_DEBUG_HID
-        // Used to debug the bytes sent to the host
-        ps2_mouse_print_report(&mouse_report);
+    // Used to debug the bytes sent to the host
+    ps2_mouse_print_report(mouse_report);
 #endif
-        host_mouse_send(&mouse_report);
-    }
-    
-    ps2_mouse_clear_report(&mouse_report);
+    host_mouse_send(mouse_report);
 }
 
 void ps2_mouse_disable_data_reporting(void) {
+#ifdef PS2_MOUSE_STREAM
+    // answers to commands go back to ps2_host_recv_response()
+    streaming = false;
+#endif
     PS2_MOUSE_SEND(PS2_MOUSE_DISABLE_DATA_REPORTING, "ps2 mouse disable data reporting"); 
 }
 
 void ps2_mouse_enable_data_reporting(void) {
     PS2_MOUSE_SEND(PS2_MOUSE_ENABLE_DATA_REPORTING, "ps2 mouse enable data reporting");
+#ifdef PS2_MOUSE_STREAM
+    packet_index = 0;
+    streaming = (ps2_mouse_mode == PS2_MOUSE_STREAM_MODE);
+#endif
 }
 
 void ps2_mouse_set_remote_mode(void) { 
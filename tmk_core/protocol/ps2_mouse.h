@@ -21,6 +21,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdbool.h>
 #include "debug.h"
 
+/* Once data reporting is enabled in stream mode the receive interrupt takes
+ * every byte for mouse packets, answers included. PS2_MOUSE_SEND and
+ * PS2_MOUSE_RECEIVE are only safe before that, in ps2_mouse_init_user(),
+ * use PS2_MOUSE_SEND_SAFE and PS2_MOUSE_SET_SAFE afterwards. */
 #define PS2_MOUSE_SEND(command, message) \
 do { \
    __attribute__ ((unused)) uint8_t rcv = ps2_host_send(command); \
@@ -118,6 +122,29 @@ static enum ps2_mouse_mode_e {
 #define PS2_MOUSE_INIT_DELAY            1000
 #endif
 
+/* In stream mode with an interrupt driven host (PS2_USE_INT or PS2_USE_USART)
+ * packets are put together in the receive interrupt and ps2_mouse_task()
+ * only sends what has arrived. Otherwise the task polls the mouse with
+ * PS2_MOUSE_READ_DATA. */
+#if !defined(PS2_MOUSE_USE_REMOTE_MODE) && (defined(PS2_USE_INT) || defined(PS2_USE_USART))
+#   define PS2_MOUSE_STREAM
+#endif
+#ifdef PS2_MOUSE_ENABLE_SCROLLING
+#   define PS2_MOUSE_PACKET_SIZE        4
+#else
+#   define PS2_MOUSE_PACKET_SIZE        3
+#endif
+/* packets with button changes waiting for ps2_mouse_task(), movement between
+ * them is added up */
+#ifndef PS2_MOUSE_PACKET_QUEUE
+#define PS2_MOUSE_PACKET_QUEUE          8
+#endif
+/* a byte arriving more than this many ms after the previous one starts a
+ * new packet */
+#ifndef PS2_MOUSE_PACKET_TIMEOUT
+#define PS2_MOUSE_PACKET_TIMEOUT        4
+#endif
+
 enum ps2_mouse_command_e {
     PS2_MOUSE_RESET = 0xFF,
     PS2_MOUSE_RESEND = 0xFE,
@@ -141,6 +141,12 @@ uint8_t ps2_host_recv_response(void)
     return pbuf_dequeue();
 }
 
+__attribute__ ((weak))
+bool ps2_host_recv_hook(uint8_t data, uint8_t error)
+{
+    return false;
+}
+
 uint8_t ps2_host_recv(void)
 {
     if (pbuf_has_data()) {
@@ -158,8 +164,10 @@ ISR(PS2_USART_RX_VECT)
     uint8_t error = PS2_USART_ERROR;    // USART error should be read before data
     uint8_t data = PS2_USART_RX_DATA;
     if (!error) {
-        pbuf_enqueue(data);
+        if (!ps2_host_recv_hook(data, PS2_ERR_NONE))
+            pbuf_enqueue(data);
     } else {
+        ps2_host_recv_hook(data, error);
         xprintf("PS2 USART error: %02X data: %02X\n", error, data);
     }
 }
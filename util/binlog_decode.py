@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""Turns the console output of a BINARY_LOG_ENABLE firmware back into text.
+
+    hid_listen | util/binlog_decode.py .build/<keyboard>_<keymap>.elf
+
+The firmware sends COBS frames between 0 bytes (see tmk_core/common/avr/binlog.h).
+Format strings are read from the ELF file the firmware was built from, a
+frame that doesn't decode is skipped.
+"""
+
+import argparse
+import struct
+import sys
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+def load_sections(path):
+    """Returns (address, data) of the ELF32 sections the firmware loads."""
+    with open(path, 'rb') as f:
+        elf = f.read()
+    if elf[:4] != b'\x7fELF' or elf[4] != 1:
+        sys.exit('%s: not an ELF32 file' % path)
+    endian = '<' if elf[5] == 1 else '>'
+    shoff, = struct.unpack_from(endian + 'I', elf, 0x20)
+    shentsize, shnum = struct.unpack_from(endian + 'HH', elf, 0x2E)
+    sections = []
+    for i in range(shnum):
+        (_, sh_type, flags, addr, offset, size) = struct.unpack_from(
+            endian + 'IIIIII', elf, shoff + i * shentsize)
+        if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size:
+            sections.append((addr, elf[offset:offset + size]))
+    return sections
+
+
+def read_string(sections, addr):
+    for start, data in sections:
+        if start <= addr < start + len(data):
+            end = data.find(b'\0', addr - start)
+            if end < 0:
+                return None
+            return data[addr - start:end].decode('latin-1')
+    return None
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame):
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+class Args:
+    def __init__(self, data, int_size):
+        self.data = data
+        self.pos = 0
+        self.int_size = int_size
+
+    def take(self, size):
+        if self.pos + size > len(self.data):
+            raise ValueError('short record')
+        value = self.data[self.pos:self.pos + size]
+        self.pos += size
+        return value
+
+    def number(self, size, signed):
+        return int.from_bytes(self.take(size), 'little', signed=signed)
+
+    def string(self):
+        end = self.data.find(b'\0', self.pos)
+        if end < 0:
+            raise ValueError('short record')
+        value = self.data[self.pos:end].decode('latin-1')
+        self.pos = end + 1
+        return value
+
+
+def xprintf(fmt, args, sections):
+    """Formats like __xprintf() in tmk_core/common/avr/xprintf.S"""
+    out = []
+    i = 0
+    while i < len(fmt):
+        c = fmt[i]
+        i += 1
+        if c != '%':
+            out.append(c)
+            continue
+        t = fmt[i:i + 1]
+        i += 1
+        if t == '%':
+            out.append('%')
+            continue
+        zero = (t == '0')
+        width = 0
+        while t.isdigit():
+            width = width * 10 + int(t)
+            t = fmt[i:i + 1]
+            i += 1
+        if t == 'c':
+            out.append(chr(args.number(args.int_size, False) & 0xFF))
+            continue
+        if t == 's':
+            out.append(args.string())
+            continue
+        if t == 'S':
+            addr = args.number(args.int_size, False)
+            out.append(read_string(sections, addr) or '<%04X>' % addr)
+            continue
+        size = args.int_size
+        if t == 'l':
+            size = 4
+            t = fmt[i:i + 1]
+            i += 1
+        if t not in ('d', 'u', 'X', 'b'):
+            break   # __xprintf() stops here
+        value = args.number(size, t == 'd')
+        if t == 'X':
+            text = '%X' % value
+        elif t == 'b':
+            text = bin(value)[2:]
+        else:
+            text = str(value)
+        out.append(text.rjust(width, '0' if zero else ' '))
+    return ''.join(out)
+
+
+def decode_record(record, sections, int_size):
+    if len(record) < 3:
+        return None
+    kind = chr(record[0])
+    value = record[1] | record[2] << 8
+    if kind == 'D':
+        return '[binlog: %d dropped]\n' % value
+    text = read_string(sections, value)
+    if text is None:
+        return None
+    if kind == 'S':
+        return text
+    if kind == 'P':
+        try:
+            return xprintf(text, Args(record[3:], int_size), sections)
+        except ValueError:
+            return None
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('elf', help='firmware ELF file')
+    parser.add_argument('input', nargs='?', help='captured output, stdin by default')
+    parser.add_argument('--int-size', type=int, default=2, help='size of int on the keyboard')
+    options = parser.parse_args()
+
+    sections = load_sections(options.elf)
+    stream = open(options.input, 'rb') if options.input else sys.stdin.buffer
+    frame = bytearray()
+    while True:
+        chunk = stream.read1(256) if hasattr(stream, 'read1') else stream.read(256)
+        if not chunk:
+            break
+        for byte in chunk:
+            if byte:
+                frame.append(byte)
+                continue
+            if frame:
+                record = cobs_decode(bytes(frame))
+                text = record and decode_record(record, sections, options.int_size)
+                if text:
+                    sys.stdout.write(text)
+                    sys.stdout.flush()
+                frame = bytearray()
+
+
+if __name__ == '__main__':
+    main()